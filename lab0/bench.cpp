@@ -0,0 +1,641 @@
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "bubblesort.hpp"
+
+// 排序性能测试：对每种元素类型、输入分布和规模运行所有排序实现，输出 CSV
+// 每个实现先预热一次，再重复运行直到累计时间达到 --min-time；规模很小时每次计时连续排序多份拷贝
+// 每次运行的结果都与 std::sort 的结果比较
+// parallelSort 对 --threads 中的每个线程数各输出一行；int32/float 另外测量 sortSmallBatch 和 mergeSorted
+
+// 16 字节的记录：按 key 排序，payload 由 key 决定，使不稳定排序的结果也可以直接比较
+struct Record {
+    std::uint64_t key;
+    std::uint64_t payload;
+
+    bool operator<(const Record& other) const { return key < other.key; }
+    bool operator==(const Record& other) const { return key == other.key && payload == other.payload; }
+};
+
+struct Options {
+    std::size_t min_n = 16;
+    std::size_t max_n = 1000000;
+    double min_time = 0.1;
+    int max_reps = 20;
+    int cpu = -1;  // 绑定到的 CPU，-1 表示允许的第一个 CPU
+    bool pin = true;
+    std::vector<std::string> types = {"int32", "int64", "float", "double", "record"};
+    std::vector<std::string> dists = {"random",     "sorted",        "reverse",     "few-unique",
+                                      "organ-pipe", "nearly-sorted", "signed-zeros"};
+    std::vector<unsigned> threads;  // parallelSort 的线程数，默认从 1 翻倍到硬件线程数
+    std::string out;
+};
+
+// ---------- 硬件计数器 ----------
+
+// 用 perf_event_open 统计本线程及其创建的线程的用户态事件，打不开的计数器记为不可用
+class PerfCounters {
+ public:
+    enum { CYCLES, BRANCH_MISSES, CACHE_MISSES, COUNT };
+
+    PerfCounters() {
+        const std::uint64_t configs[COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_BRANCH_MISSES,
+                                              PERF_COUNT_HW_CACHE_MISSES};
+        for (int i = 0; i < COUNT; ++i) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds_[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    bool available(int i) const { return fds_[i] >= 0; }
+
+    void start() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    void stop() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+    }
+
+    std::uint64_t value(int i) const {
+        std::uint64_t v = 0;
+        if (fds_[i] < 0 || read(fds_[i], &v, sizeof(v)) != (ssize_t)sizeof(v)) {
+            return 0;
+        }
+        return v;
+    }
+
+ private:
+    int fds_[COUNT];
+};
+
+// ---------- 线程绑定 ----------
+
+// 顺序排序绑定到一个 CPU，减少迁移带来的抖动；并行排序运行期间恢复原来的 CPU 集合
+class Affinity {
+ public:
+    explicit Affinity(const Options& options) : pinned_(false) {
+        CPU_ZERO(&original_);
+        if (!options.pin || sched_getaffinity(0, sizeof(original_), &original_) != 0) {
+            return;
+        }
+        int cpu = options.cpu;
+        for (int c = 0; cpu < 0 && c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &original_)) {
+                cpu = c;
+            }
+        }
+        CPU_ZERO(&single_);
+        CPU_SET(cpu, &single_);
+        if (sched_setaffinity(0, sizeof(single_), &single_) != 0) {
+            std::perror("sched_setaffinity");
+            return;
+        }
+        pinned_ = true;
+        cpu_ = cpu;
+    }
+
+    bool pinned() const { return pinned_; }
+    int cpu() const { return cpu_; }
+
+    void release() {
+        if (pinned_) {
+            sched_setaffinity(0, sizeof(original_), &original_);
+        }
+    }
+
+    void pin() {
+        if (pinned_) {
+            sched_setaffinity(0, sizeof(single_), &single_);
+        }
+    }
+
+ private:
+    bool pinned_;
+    int cpu_ = -1;
+    cpu_set_t original_, single_;
+};
+
+// ---------- 输入分布 ----------
+
+static void make_value(std::uint64_t x, std::int32_t& v) { v = (std::int32_t)x; }
+static void make_value(std::uint64_t x, std::int64_t& v) { v = (std::int64_t)x; }
+static void make_value(std::uint64_t x, float& v) { v = (float)(std::int64_t)x / 4096.0f; }
+static void make_value(std::uint64_t x, double& v) { v = (double)(std::int64_t)x / 4096.0; }
+static void make_value(std::uint64_t x, Record& v) {
+    v.key = x;
+    v.payload = x * 0x9E3779B97F4A7C15ull;
+}
+
+// signed-zeros 分布：浮点数为 -0.0、+0.0、1、-1 四种值，其它类型为 0 到 3，都有大量重复
+template <class T>
+static void make_signed_zero(std::uint64_t x, T& v) { make_value(x % 4, v); }
+static void make_signed_zero(std::uint64_t x, float& v) {
+    static const float values[] = {-0.0f, 0.0f, 1.0f, -1.0f};
+    v = values[x % 4];
+}
+static void make_signed_zero(std::uint64_t x, double& v) {
+    static const double values[] = {-0.0, 0.0, 1.0, -1.0};
+    v = values[x % 4];
+}
+
+template <class T>
+static std::vector<T> generate(const std::string& dist, std::size_t n, std::mt19937_64& rng) {
+    std::vector<T> v(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::uint64_t x = rng();
+        if (dist == "few-unique") {
+            x %= 16;
+        } else if (dist == "organ-pipe") {
+            // 前半升序、后半降序
+            x = std::min(i, n - 1 - i);
+        }
+        if (dist == "signed-zeros") {
+            make_signed_zero(x, v[i]);
+        } else {
+            make_value(x, v[i]);
+        }
+    }
+    if (dist == "sorted" || dist == "nearly-sorted") {
+        std::sort(v.begin(), v.end());
+    } else if (dist == "reverse") {
+        std::sort(v.begin(), v.end());
+        std::reverse(v.begin(), v.end());
+    }
+    if (dist == "nearly-sorted") {
+        // 随机交换约 1% 的元素对
+        std::size_t swaps = std::max<std::size_t>(1, n / 100);
+        for (std::size_t i = 0; i < swaps && n > 1; ++i) {
+            std::swap(v[rng() % n], v[rng() % n]);
+        }
+    }
+    return v;
+}
+
+// ---------- 排序实现 ----------
+
+// 原来的冒泡排序，作为对照
+template <class T>
+static void legacyBubbleSort(T* begin, T* end) {
+    std::size_t n = end - begin;
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        for (std::size_t j = 0; j + 1 < n - i; ++j) {
+            if (begin[j + 1] < begin[j]) {
+                std::swap(begin[j], begin[j + 1]);
+            }
+        }
+    }
+}
+
+template <class T>
+struct Impl {
+    std::string name;
+    std::size_t max_n;  // 超过该规模时跳过
+    unsigned threads;
+    std::function<void(T*, T*)> sort;
+};
+
+// 冒泡排序超过该规模时耗时过长，跳过
+const std::size_t bubble_limit = 4096;
+const std::size_t no_limit = ~std::size_t(0);
+
+template <class T>
+static void add_common(std::vector<Impl<T> >& impls, const Options& options) {
+    impls.push_back({"std::sort", no_limit, 1, [](T* b, T* e) { std::sort(b, e); }});
+    impls.push_back({"bubble", bubble_limit, 1, [](T* b, T* e) { legacyBubbleSort(b, e); }});
+    impls.push_back({"pdqSort", no_limit, 1, [](T* b, T* e) { pdqSort(b, e); }});
+    for (unsigned t : options.threads) {
+        impls.push_back({"parallelSort", no_limit, t, [t](T* b, T* e) { parallelSort(b, e, t); }});
+    }
+}
+
+template <class T>
+static std::vector<Impl<T> > implementations(const Options& options) {
+    std::vector<Impl<T> > impls;
+    add_common(impls, options);
+    impls.push_back({"radixSort", no_limit, 1, [](T* b, T* e) { radixSort(b, e); }});
+    return impls;
+}
+
+template <>
+std::vector<Impl<std::int32_t> > implementations<std::int32_t>(const Options& options) {
+    std::vector<Impl<std::int32_t> > impls;
+    add_common(impls, options);
+    impls.push_back({"radixSort", no_limit, 1, [](std::int32_t* b, std::int32_t* e) { radixSort(b, e); }});
+    impls.push_back({"sortSmall", simd_sort_max, 1, [](std::int32_t* b, std::int32_t* e) { sortSmall(b, e - b); }});
+    return impls;
+}
+
+template <>
+std::vector<Impl<float> > implementations<float>(const Options& options) {
+    std::vector<Impl<float> > impls;
+    add_common(impls, options);
+    impls.push_back({"radixSort", no_limit, 1, [](float* b, float* e) { radixSort(b, e); }});
+    impls.push_back({"sortSmall", simd_sort_max, 1, [](float* b, float* e) { sortSmall(b, e - b); }});
+    return impls;
+}
+
+template <>
+std::vector<Impl<Record> > implementations<Record>(const Options& options) {
+    std::vector<Impl<Record> > impls;
+    add_common(impls, options);
+    impls.push_back({"radixSortBy", no_limit, 1,
+                     [](Record* b, Record* e) { radixSortBy(b, e, [](const Record& r) { return r.key; }); }});
+    return impls;
+}
+
+// ---------- 测量 ----------
+
+// -0.0 与 +0.0 用 == 比较相等，逐元素与 std::sort 的结果比较发现不了符号被改变，
+// 因此另外比较负零的个数；不含 NaN 时两者都一致就说明结果是输入的一个排列
+template <class T>
+static std::size_t negative_zeros(const T*, std::size_t) {
+    return 0;
+}
+
+template <class F>
+static std::size_t count_negative_zeros(const F* p, std::size_t n) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        count += p[i] == 0 && std::signbit(p[i]);
+    }
+    return count;
+}
+
+static std::size_t negative_zeros(const float* p, std::size_t n) { return count_negative_zeros(p, n); }
+static std::size_t negative_zeros(const double* p, std::size_t n) { return count_negative_zeros(p, n); }
+
+struct Result {
+    int reps;
+    double median_ns, min_ns;  // 每元素纳秒数
+    double counters[PerfCounters::COUNT];  // 每元素事件数，不可用时为负数
+    bool correct;
+};
+
+// 规模很小时每次计时连续排序多份拷贝，使计时开销可以忽略
+static std::size_t copies_for(std::size_t n) {
+    return std::max<std::size_t>(1, 65536 / std::max<std::size_t>(n, 1));
+}
+
+template <class T>
+static Result measure(const Impl<T>& impl, const std::vector<T>& input, const std::vector<T>& expected,
+                      const Options& options, PerfCounters& perf, Affinity& affinity) {
+    const std::size_t n = input.size();
+    const std::size_t copies = copies_for(n);
+    std::vector<T> work(n * copies);
+    Result result;
+    result.correct = true;
+    std::uint64_t events[PerfCounters::COUNT] = {0, 0, 0};
+    std::vector<double> samples;
+    double total = 0;
+    const std::size_t expected_negative_zeros = negative_zeros(expected.data(), n);
+
+    if (impl.threads > 1) {
+        affinity.release();
+    }
+    // 第 0 次为预热，不计入结果
+    for (int rep = 0; rep <= options.max_reps; ++rep) {
+        for (std::size_t c = 0; c < copies; ++c) {
+            std::copy(input.begin(), input.end(), work.begin() + c * n);
+        }
+        perf.start();
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t c = 0; c < copies; ++c) {
+            impl.sort(work.data() + c * n, work.data() + (c + 1) * n);
+        }
+        auto end = std::chrono::steady_clock::now();
+        perf.stop();
+
+        for (std::size_t c = 0; c < copies; ++c) {
+            const T* sorted = work.data() + c * n;
+            if (!std::equal(expected.begin(), expected.end(), sorted) ||
+                negative_zeros(sorted, n) != expected_negative_zeros) {
+                result.correct = false;
+            }
+        }
+        if (rep == 0) {
+            continue;
+        }
+        double seconds = std::chrono::duration<double>(end - start).count();
+        samples.push_back(seconds * 1e9 / (n * copies));
+        total += seconds;
+        for (int i = 0; i < PerfCounters::COUNT; ++i) {
+            events[i] += perf.value(i);
+        }
+        if (total >= options.min_time) {
+            break;
+        }
+    }
+    if (impl.threads > 1) {
+        affinity.pin();
+    }
+
+    std::sort(samples.begin(), samples.end());
+    result.reps = (int)samples.size();
+    result.median_ns = samples[samples.size() / 2];
+    result.min_ns = samples.front();
+    for (int i = 0; i < PerfCounters::COUNT; ++i) {
+        result.counters[i] = perf.available(i) ? (double)events[i] / ((double)n * copies * samples.size()) : -1;
+    }
+    return result;
+}
+
+// ---------- 主程序 ----------
+
+static std::vector<std::string> split_list(const char* s) {
+    std::vector<std::string> items;
+    std::string item;
+    for (; *s; ++s) {
+        if (*s == ',') {
+            items.push_back(item);
+            item.clear();
+        } else {
+            item += *s;
+        }
+    }
+    items.push_back(item);
+    return items;
+}
+
+static void usage(const char* prog) {
+    std::fprintf(stderr,
+                 "usage: %s [options]\n"
+                 "  --min-n N        最小规模（默认 16）\n"
+                 "  --max-n N        最大规模（默认 1000000，最大 100000000）\n"
+                 "  --types LIST     int32,int64,float,double,record\n"
+                 "  --dists LIST     random,sorted,reverse,few-unique,organ-pipe,nearly-sorted,\n"
+                 "                   signed-zeros\n"
+                 "  --min-time SEC   每个实现累计计时的下限（默认 0.1）\n"
+                 "  --max-reps N     重复次数上限（默认 20）\n"
+                 "  --threads LIST   parallelSort 的线程数（默认 1,2,4,... 直到硬件线程数）\n"
+                 "  --cpu N          绑定到的 CPU\n"
+                 "  --no-pin         不绑定 CPU\n"
+                 "  --out FILE       CSV 写入文件（默认标准输出）\n",
+                 prog);
+}
+
+static bool parse_args(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--no-pin") {
+            options.pin = false;
+        } else if (arg == "--min-n" && has_value) {
+            options.min_n = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-n" && has_value) {
+            options.max_n = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--types" && has_value) {
+            options.types = split_list(argv[++i]);
+        } else if (arg == "--dists" && has_value) {
+            options.dists = split_list(argv[++i]);
+        } else if (arg == "--min-time" && has_value) {
+            options.min_time = std::atof(argv[++i]);
+        } else if (arg == "--max-reps" && has_value) {
+            options.max_reps = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && has_value) {
+            options.threads.clear();
+            for (const std::string& t : split_list(argv[++i])) {
+                options.threads.push_back(std::max(1, std::atoi(t.c_str())));
+            }
+        } else if (arg == "--cpu" && has_value) {
+            options.cpu = std::atoi(argv[++i]);
+        } else if (arg == "--out" && has_value) {
+            options.out = argv[++i];
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Context {
+    Options options;
+    std::FILE* csv;
+    PerfCounters perf;
+    Affinity affinity;
+    std::mt19937_64 rng;
+    std::size_t memory_limit;
+    int failures;
+
+    explicit Context(const Options& opts)
+        : options(opts), csv(stdout), affinity(opts), rng(42), memory_limit(0), failures(0) {}
+};
+
+static void print_counter(std::FILE* f, double v) {
+    if (v < 0) {
+        std::fprintf(f, ",");
+    } else {
+        std::fprintf(f, ",%.4f", v);
+    }
+}
+
+static void emit_row(Context& ctx, const char* type, const std::string& dist, std::size_t n,
+                     const std::string& impl, unsigned threads, const Result& r) {
+    std::fprintf(ctx.csv, "%s,%s,%zu,%s,%u,%d,%.3f,%.3f", type, dist.c_str(), n, impl.c_str(), threads, r.reps,
+                 r.median_ns, r.min_ns);
+    for (double c : r.counters) {
+        print_counter(ctx.csv, c);
+    }
+    std::fprintf(ctx.csv, ",%d\n", r.correct ? 1 : 0);
+    std::fflush(ctx.csv);
+    if (!r.correct) {
+        std::fprintf(stderr, "WRONG: %s %s n=%zu %s threads=%u\n", type, dist.c_str(), n, impl.c_str(), threads);
+        ++ctx.failures;
+    }
+}
+
+template <class T>
+static void run_impl(Context& ctx, const char* type, const std::string& dist, const Impl<T>& impl,
+                     const std::vector<T>& input, const std::vector<T>& expected) {
+    std::fprintf(stderr, "%-7s %-14s %10zu %s/%u\n", type, dist.c_str(), input.size(), impl.name.c_str(),
+                 impl.threads);
+    Result r = measure(impl, input, expected, ctx.options, ctx.perf, ctx.affinity);
+    emit_row(ctx, type, dist, input.size(), impl.name, impl.threads, r);
+}
+
+// 其它类型没有 SIMD 内核
+template <class T>
+static void run_kernels(Context&, const char*, const std::string&, const std::vector<T>&, std::false_type) {}
+
+// sortSmallBatch：把输入看作若干个长度为 len 的独立小数组，与逐个 std::sort 对比
+// mergeSorted：输入的前后两半各自有序，归并到辅助数组再复制回来，与 std::merge 对比
+template <class T>
+static void run_kernels(Context& ctx, const char* type, const std::string& dist, const std::vector<T>& input,
+                        std::true_type) {
+    const std::size_t n = input.size();
+    for (std::size_t len : {8, 16, 32, 64}) {
+        if (n < len) {
+            continue;
+        }
+        std::shared_ptr<std::vector<std::size_t> > offsets(new std::vector<std::size_t>);
+        for (std::size_t i = 0; i < n; i += len) {
+            offsets->push_back(i);
+        }
+        offsets->push_back(n);
+        std::vector<T> expected = input;
+        for (std::size_t i = 0; i + 1 < offsets->size(); ++i) {
+            std::sort(expected.begin() + (*offsets)[i], expected.begin() + (*offsets)[i + 1]);
+        }
+        std::string suffix = "/" + std::to_string(len);
+        Impl<T> batch = {"sortSmallBatch" + suffix, no_limit, 1,
+                         [offsets](T* b, T*) { sortSmallBatch(b, offsets->data(), offsets->size() - 1); }};
+        Impl<T> per_array = {"std::sort" + suffix, no_limit, 1, [offsets](T* b, T*) {
+                                 for (std::size_t i = 0; i + 1 < offsets->size(); ++i) {
+                                     std::sort(b + (*offsets)[i], b + (*offsets)[i + 1]);
+                                 }
+                             }};
+        run_impl(ctx, type, dist, batch, input, expected);
+        run_impl(ctx, type, dist, per_array, input, expected);
+    }
+
+    std::vector<T> halves = input;
+    std::sort(halves.begin(), halves.begin() + n / 2);
+    std::sort(halves.begin() + n / 2, halves.end());
+    std::vector<T> expected = input;
+    std::sort(expected.begin(), expected.end());
+    std::shared_ptr<std::vector<T> > scratch(new std::vector<T>(n));
+    Impl<T> simd_merge = {"mergeSorted", no_limit, 1, [scratch](T* b, T* e) {
+                              std::size_t h = (e - b) / 2;
+                              mergeSorted(b, h, b + h, (e - b) - h, scratch->data());
+                              std::copy(scratch->begin(), scratch->begin() + (e - b), b);
+                          }};
+    Impl<T> std_merge = {"std::merge", no_limit, 1, [scratch](T* b, T* e) {
+                             T* mid = b + (e - b) / 2;
+                             std::merge(b, mid, mid, e, scratch->begin());
+                             std::copy(scratch->begin(), scratch->begin() + (e - b), b);
+                         }};
+    run_impl(ctx, type, dist, simd_merge, halves, expected);
+    run_impl(ctx, type, dist, std_merge, halves, expected);
+}
+
+template <class T>
+static void run_type(Context& ctx, const char* type) {
+    static const std::size_t sizes[] = {16, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    typedef std::integral_constant<bool, std::is_same<T, std::int32_t>::value || std::is_same<T, float>::value>
+        has_kernels;
+    std::vector<Impl<T> > impls = implementations<T>(ctx.options);
+    for (const std::string& dist : ctx.options.dists) {
+        for (std::size_t n : sizes) {
+            if (n < ctx.options.min_n || n > ctx.options.max_n) {
+                continue;
+            }
+            // 输入、期望结果、工作区以及排序用的辅助数组
+            if (5 * n * sizeof(T) > ctx.memory_limit) {
+                std::fprintf(stderr, "skip %s %s n=%zu: not enough memory\n", type, dist.c_str(), n);
+                continue;
+            }
+            std::vector<T> input = generate<T>(dist, n, ctx.rng);
+            std::vector<T> expected = input;
+            std::sort(expected.begin(), expected.end());
+            for (const Impl<T>& impl : impls) {
+                if (n <= impl.max_n) {
+                    run_impl(ctx, type, dist, impl, input, expected);
+                }
+            }
+            run_kernels(ctx, type, dist, input, has_kernels());
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_args(argc, argv, options)) {
+        return 2;
+    }
+    if (options.threads.empty()) {
+        unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned t = 1;; t = std::min(t * 2, max_threads)) {
+            options.threads.push_back(t);
+            if (t == max_threads) {
+                break;
+            }
+        }
+    }
+    Context ctx(options);
+    if (!options.out.empty()) {
+        ctx.csv = std::fopen(options.out.c_str(), "w");
+        if (!ctx.csv) {
+            std::perror(options.out.c_str());
+            return 1;
+        }
+    }
+    // 最多使用一半的物理内存
+    ctx.memory_limit = (std::size_t)sysconf(_SC_PHYS_PAGES) * (std::size_t)sysconf(_SC_PAGESIZE) / 2;
+
+    std::fprintf(stderr, "simd: %s, pinned: %s", simdSortIsa(), ctx.affinity.pinned() ? "cpu " : "no");
+    if (ctx.affinity.pinned()) {
+        std::fprintf(stderr, "%d", ctx.affinity.cpu());
+    }
+    std::fprintf(stderr, ", perf counters: %s\n", ctx.perf.available(PerfCounters::CYCLES) ? "yes" : "no");
+
+    std::fprintf(ctx.csv,
+                 "type,dist,n,impl,threads,reps,ns_per_elem,min_ns_per_elem,cycles_per_elem,branch_misses_per_elem,"
+                 "cache_misses_per_elem,correct\n");
+    for (const std::string& type : options.types) {
+        if (type == "int32") {
+            run_type<std::int32_t>(ctx, "int32");
+        } else if (type == "int64") {
+            run_type<std::int64_t>(ctx, "int64");
+        } else if (type == "float") {
+            run_type<float>(ctx, "float");
+        } else if (type == "double") {
+            run_type<double>(ctx, "double");
+        } else if (type == "record") {
+            run_type<Record>(ctx, "record");
+        } else {
+            std::fprintf(stderr, "unknown type: %s\n", type.c_str());
+            return 2;
+        }
+    }
+
+    if (ctx.csv != stdout) {
+        std::fclose(ctx.csv);
+    }
+    if (ctx.failures > 0) {
+        std::fprintf(stderr, "%d runs produced wrong results\n", ctx.failures);
+        return 1;
+    }
+    return 0;
+}
@@ -1,13 +1,7 @@
-#include <iostream>
-#include <vector>
-
-void bubbleSort(std::vector<int>& arr) {
-    int n = arr.size();
-    for (int i = 0; i < n - 1; ++i) {
-        for (int j = 0; j < n - i - 1; ++j) {
-            if (arr[j] > arr[j + 1]) {
-                std::swap(arr[j], arr[j + 1]);
-            }
-        }
-    }
-}
\ No newline at end of file
+#include <iostream>
+#include <vector>
+#include "bubblesort.hpp"
+
+void bubbleSort(std::vector<int>& arr) {
+    fastSort(arr.begin(), arr.end());
+}
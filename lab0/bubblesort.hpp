@@ -1,4 +1,8 @@
-#include <iostream>
-#include <vector>
-
-void bubbleSort(std::vector<int>& arr);
\ No newline at end of file
+#include <iostream>
+#include <vector>
+#include "pdqsort.hpp"
+#include "radixsort.hpp"
+#include "parallelsort.hpp"
+
+// 兼容原有接口，内部使用 fastSort（int 走基数排序）
+void bubbleSort(std::vector<int>& arr);
@@ -0,0 +1,526 @@
+#include "extsort.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "parallelsort.hpp"
+
+namespace {
+
+typedef std::int32_t value_type;
+
+// 归并时每块读写缓冲区的大小范围（字节）：段数多到每块小于下限时改为多轮归并
+// 多一轮归并就要把全部数据多读写一遍，因此下限取得很小，只要一页，尽量一轮归并完
+const std::size_t min_block_bytes = std::size_t(4) << 10;
+const std::size_t max_block_bytes = std::size_t(16) << 20;
+// 内存预算的下限：两路归并时两段各两块、输出两块，每块不小于 min_block_bytes
+const std::size_t min_memory_bytes = 6 * min_block_bytes;
+
+std::runtime_error sys_error(const std::string &what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// 自动关闭的文件描述符
+class FileDescriptor {
+ public:
+    explicit FileDescriptor(int fd = -1) : fd_(fd) {}
+    ~FileDescriptor() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+    FileDescriptor(FileDescriptor &&other) : fd_(other.fd_) { other.fd_ = -1; }
+    FileDescriptor &operator=(FileDescriptor &&other) {
+        std::swap(fd_, other.fd_);
+        return *this;
+    }
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+    int get() const { return fd_; }
+
+ private:
+    int fd_;
+};
+
+// 从 offset 处读满 bytes 字节，*done 为实际读到的字节数（文件提前结束时较少）；成功返回 0，失败返回 errno
+int read_all(int fd, void *buf, std::size_t bytes, off_t offset, std::size_t *done) {
+    char *p = static_cast<char *>(buf);
+    *done = 0;
+    while (*done < bytes) {
+        ssize_t n = pread(fd, p + *done, bytes - *done, offset + *done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        if (n == 0) {
+            break;
+        }
+        *done += n;
+    }
+    return 0;
+}
+
+std::size_t read_full(int fd, void *buf, std::size_t bytes, off_t offset, const char *what) {
+    std::size_t done;
+    int err = read_all(fd, buf, bytes, offset, &done);
+    if (err != 0) {
+        errno = err;
+        throw sys_error(what);
+    }
+    return done;
+}
+
+// 写出全部数据，成功返回 0，失败返回 errno
+int write_all(int fd, const void *buf, std::size_t bytes) {
+    const char *p = static_cast<const char *>(buf);
+    while (bytes > 0) {
+        ssize_t n = write(fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+void write_full(int fd, const void *buf, std::size_t bytes, const std::string &what) {
+    int err = write_all(fd, buf, bytes);
+    if (err != 0) {
+        errno = err;
+        throw sys_error(what);
+    }
+}
+
+// 一个有序段：已删除的临时文件及其元素个数
+struct Run {
+    FileDescriptor fd;
+    std::size_t count;
+};
+
+Run create_run(const std::string &dir) {
+    std::string path = dir + "/extsort-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    int fd = mkstemp(name.data());
+    if (fd < 0) {
+        throw sys_error("cannot create temporary file in " + dir);
+    }
+    unlink(name.data());
+    Run run;
+    run.fd = FileDescriptor(fd);
+    run.count = 0;
+    return run;
+}
+
+class RunReader;
+
+// 后台读线程：按提交顺序把各有序段的下一块读入它们的备用缓冲区
+// 所有有序段共用一个线程，读盘与归并重叠，线程数不随段数增长
+class Prefetcher {
+ public:
+    Prefetcher() : stop_(false) { thread_ = std::thread(&Prefetcher::reader_loop, this); }
+
+    ~Prefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+
+    void submit(RunReader *reader) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(reader);
+        }
+        cond_.notify_all();
+    }
+
+    // 等待 reader 的备用缓冲区读完，返回读取时的 errno（0 表示成功）
+    int wait(RunReader *reader);
+
+ private:
+    void reader_loop();
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<RunReader *> queue_;
+    bool stop_;
+    std::thread thread_;
+};
+
+// 按块顺序读取一个有序段：归并当前块的同时，Prefetcher 把下一块读入备用缓冲区
+class RunReader {
+ public:
+    RunReader(const Run &run, std::size_t block, Prefetcher &prefetcher)
+        : fd_(run.fd.get()), count_(run.count), next_(0), current_(block), spare_(block), pos_(0), len_(0),
+          spare_len_(0), submitted_(false), ready_(false), error_(0), prefetcher_(&prefetcher) {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        if (count_ > 0) {
+            submit();
+            advance();
+        }
+    }
+
+    bool empty() const { return pos_ == len_; }
+    value_type head() const { return current_[pos_]; }
+
+    void pop() {
+        if (++pos_ == len_) {
+            advance();
+        }
+    }
+
+ private:
+    friend class Prefetcher;
+
+    // 在后台线程中读取下一块到备用缓冲区；从提交到 wait 返回之间只有后台线程访问 spare_、spare_len_ 和 next_
+    int fill_spare() {
+        std::size_t n = std::min(spare_.size(), count_ - next_);
+        std::size_t bytes;
+        int err = read_all(fd_, spare_.data(), n * sizeof(value_type), off_t(next_) * sizeof(value_type), &bytes);
+        if (err == 0 && bytes != n * sizeof(value_type)) {
+            err = EIO;
+        }
+        next_ += n;
+        spare_len_ = n;
+        return err;
+    }
+
+    void submit() {
+        submitted_ = true;
+        prefetcher_->submit(this);
+    }
+
+    // 换上已经读好的备用缓冲区，并提交再下一块的读取；没有已提交的读取时说明整段已读完
+    void advance() {
+        pos_ = len_ = 0;
+        if (!submitted_) {
+            return;
+        }
+        submitted_ = false;
+        int err = prefetcher_->wait(this);
+        if (err != 0) {
+            errno = err;
+            throw sys_error("read run");
+        }
+        current_.swap(spare_);
+        len_ = spare_len_;
+        if (next_ < count_) {
+            submit();
+        }
+    }
+
+    int fd_;
+    std::size_t count_;
+    std::size_t next_;  // 下一次读取的元素下标
+    std::vector<value_type> current_, spare_;
+    std::size_t pos_, len_;
+    std::size_t spare_len_;
+    bool submitted_;  // 是否有已提交、尚未取走的读取，只由归并线程访问
+    bool ready_;  // 备用缓冲区已读好，由 Prefetcher 的锁保护
+    int error_;
+    Prefetcher *prefetcher_;
+};
+
+int Prefetcher::wait(RunReader *reader) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [reader] { return reader->ready_; });
+    reader->ready_ = false;
+    return reader->error_;
+}
+
+void Prefetcher::reader_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (stop_) {
+            return;
+        }
+        RunReader *reader = queue_.front();
+        queue_.pop_front();
+        lock.unlock();
+        int err = reader->fill_spare();
+        lock.lock();
+        reader->error_ = err;
+        reader->ready_ = true;
+        cond_.notify_all();
+    }
+}
+
+// 双缓冲写出：调用者填满一块缓冲区后交给后台线程写出，同时继续填另一块
+class BufferedWriter {
+ public:
+    BufferedWriter(int fd, std::size_t block)
+        : fd_(fd), fill_(block), flush_(block), pending_(0), stop_(false), failed_(false), error_(0) {
+        fill_.clear();
+        thread_ = std::thread(&BufferedWriter::writer_loop, this);
+    }
+
+    ~BufferedWriter() {
+        if (thread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cond_.notify_all();
+            thread_.join();
+        }
+    }
+
+    void push(value_type v) {
+        fill_.push_back(v);
+        if (fill_.size() == fill_.capacity()) {
+            hand_off();
+        }
+    }
+
+    // 写出剩余数据并等待后台线程结束
+    void finish() {
+        hand_off();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+        if (failed_) {
+            errno = error_;
+            throw sys_error("write");
+        }
+    }
+
+ private:
+    // 等待后台线程写完上一块，再交换缓冲区
+    void hand_off() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return pending_ == 0; });
+        if (failed_) {
+            errno = error_;
+            throw sys_error("write");
+        }
+        fill_.swap(flush_);
+        pending_ = flush_.size();
+        fill_.clear();
+        lock.unlock();
+        cond_.notify_all();
+    }
+
+    void writer_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cond_.wait(lock, [this] { return pending_ > 0 || stop_; });
+            if (pending_ == 0) {
+                return;
+            }
+            lock.unlock();
+            int err = write_all(fd_, flush_.data(), flush_.size() * sizeof(value_type));
+            lock.lock();
+            if (err != 0) {
+                failed_ = true;
+                error_ = err;
+            }
+            pending_ = 0;
+            cond_.notify_all();
+        }
+    }
+
+    int fd_;
+    std::vector<value_type> fill_, flush_;
+    std::size_t pending_;  // 后台线程正在写出的元素个数
+    bool stop_;
+    bool failed_;
+    int error_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread thread_;
+};
+
+// 败者树：内部结点记录比赛的败者，tree_[0] 为总胜者
+// 换上胜者所在段的下一个元素后，只需沿该叶子到根的路径重赛，比较 log2(k) 次
+class LoserTree {
+ public:
+    explicit LoserTree(std::vector<RunReader> &runs) : runs_(runs), k_(runs.size()), tree_(k_) {
+        tree_[0] = k_ == 1 ? 0 : build(1);
+    }
+
+    bool empty() const { return runs_[tree_[0]].empty(); }
+    value_type top() const { return runs_[tree_[0]].head(); }
+
+    void pop() {
+        std::size_t winner = tree_[0];
+        runs_[winner].pop();
+        for (std::size_t node = (winner + k_) / 2; node > 0; node /= 2) {
+            if (beats(tree_[node], winner)) {
+                std::swap(tree_[node], winner);
+            }
+        }
+        tree_[0] = winner;
+    }
+
+ private:
+    // 已读完的段视为无穷大
+    bool beats(std::size_t a, std::size_t b) const {
+        if (runs_[a].empty()) {
+            return false;
+        }
+        return runs_[b].empty() || runs_[a].head() < runs_[b].head();
+    }
+
+    // 结点 node 的子结点为 2node、2node+1，下标 k 及以上的结点是叶子（第 node - k 段）
+    std::size_t build(std::size_t node) {
+        if (node >= k_) {
+            return node - k_;
+        }
+        std::size_t l = build(2 * node), r = build(2 * node + 1);
+        if (beats(r, l)) {
+            std::swap(l, r);
+        }
+        tree_[node] = r;
+        return l;
+    }
+
+    std::vector<RunReader> &runs_;
+    std::size_t k_;
+    std::vector<std::size_t> tree_;
+};
+
+// 把 runs[first, last) 归并后写入 out_fd，返回写出的元素个数
+std::size_t merge_runs(std::vector<Run> &runs, std::size_t first, std::size_t last, int out_fd, std::size_t memory) {
+    std::size_t k = last - first;
+    // 每段两块读缓冲区（当前块和预读块），输出两块，合计不超过内存预算
+    std::size_t block_bytes = std::min(max_block_bytes, memory / (2 * k + 2));
+    std::size_t block = std::max<std::size_t>(block_bytes / sizeof(value_type), 1);
+
+    // prefetcher 声明在 readers 之后、先于 readers 析构，后台线程退出前 readers 一直有效
+    std::vector<RunReader> readers;
+    readers.reserve(k);
+    Prefetcher prefetcher;
+    for (std::size_t i = first; i < last; ++i) {
+        readers.emplace_back(runs[i], block, prefetcher);
+    }
+    LoserTree tree(readers);
+    BufferedWriter writer(out_fd, block);
+    std::size_t count = 0;
+    while (!tree.empty()) {
+        writer.push(tree.top());
+        tree.pop();
+        ++count;
+    }
+    writer.finish();
+    return count;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+void externalSort(const std::string &input, const std::string &output, const ExtSortOptions &options) {
+    auto start = std::chrono::steady_clock::now();
+    if (options.memory_bytes < min_memory_bytes) {
+        throw std::runtime_error("memory budget must be at least " + std::to_string(min_memory_bytes >> 10) + " KiB");
+    }
+    FileDescriptor in(open(input.c_str(), O_RDONLY));
+    if (in.get() < 0) {
+        throw sys_error("cannot open " + input);
+    }
+    struct stat st;
+    if (fstat(in.get(), &st) < 0) {
+        throw sys_error("cannot stat " + input);
+    }
+    if (st.st_size % sizeof(value_type) != 0) {
+        throw std::runtime_error(input + ": size is not a multiple of " + std::to_string(sizeof(value_type)));
+    }
+    std::size_t total = st.st_size / sizeof(value_type);
+    posix_fadvise(in.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // 第一阶段：parallelSort 需要与数据等长的辅助数组，每块只用一半的内存预算
+    std::size_t chunk = std::max<std::size_t>(options.memory_bytes / sizeof(value_type) / 2, 1);
+    chunk = std::min(chunk, std::max<std::size_t>(total, 1));
+    std::vector<value_type> buf(chunk);
+    std::vector<Run> runs;
+    for (std::size_t done = 0; done < total;) {
+        std::size_t n = std::min(chunk, total - done);
+        std::size_t bytes = read_full(in.get(), buf.data(), n * sizeof(value_type), off_t(done) * sizeof(value_type),
+                                      ("read " + input).c_str());
+        if (bytes != n * sizeof(value_type)) {
+            throw std::runtime_error(input + ": file changed while sorting");
+        }
+        parallelSort(buf.begin(), buf.begin() + n, options.threads);
+        done += n;
+
+        // 只有一块时不需要临时文件，在写输出前退出循环
+        if (done == total && runs.empty()) {
+            break;
+        }
+        runs.push_back(create_run(options.temp_dir));
+        write_full(runs.back().fd.get(), buf.data(), n * sizeof(value_type), "write run");
+        runs.back().count = n;
+    }
+    if (options.verbose) {
+        std::fprintf(stderr, "extsort: %zu elements, %zu runs, run phase %.2fs\n", total, runs.size(),
+                     seconds_since(start));
+    }
+
+    // 输入全部读完后才打开输出，input 与 output 相同时也不会覆盖未读的数据
+    if (runs.empty()) {
+        buf.resize(total);
+        FileDescriptor out(open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        if (out.get() < 0) {
+            throw sys_error("cannot open " + output);
+        }
+        write_full(out.get(), buf.data(), buf.size() * sizeof(value_type), "write " + output);
+        return;
+    }
+    std::vector<value_type>().swap(buf);
+
+    // 与 merge_runs 相同，k 路归并需要 2k + 2 块；块不小于 min_block_bytes 时最多能同时归并 fan_in 段，
+    // 段数更多时先分组归并
+    std::size_t fan_in = (options.memory_bytes / min_block_bytes - 2) / 2;
+    std::size_t passes = 1;
+    while (runs.size() > fan_in) {
+        std::vector<Run> merged;
+        for (std::size_t first = 0; first < runs.size(); first += fan_in) {
+            std::size_t last = std::min(first + fan_in, runs.size());
+            if (last - first == 1) {
+                merged.push_back(std::move(runs[first]));
+                continue;
+            }
+            merged.push_back(create_run(options.temp_dir));
+            merged.back().count = merge_runs(runs, first, last, merged.back().fd.get(), options.memory_bytes);
+        }
+        runs.swap(merged);
+        ++passes;
+    }
+
+    FileDescriptor out(open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    if (out.get() < 0) {
+        throw sys_error("cannot open " + output);
+    }
+    merge_runs(runs, 0, runs.size(), out.get(), options.memory_bytes);
+    if (options.verbose) {
+        std::fprintf(stderr, "extsort: %zu merge passes, total %.2fs\n", passes, seconds_since(start));
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef EXTSORT_HPP
+#define EXTSORT_HPP
+
+#include <cstddef>
+#include <string>
+
+// 外部排序：对超过内存的二进制文件排序，文件内容为本机字节序的 int32 数组
+// 第一阶段按内存预算分块读入，用 parallelSort 排序后写入临时文件（每个临时文件称为一个有序段）
+// 第二阶段用败者树多路归并各有序段：每段有两块读缓冲区，由后台线程提前读入下一块；
+// 输出由后台线程写出，与归并交替使用两块缓冲区；读写缓冲区合计不超过内存预算
+// 有序段过多、每段分到的缓冲区过小时，先分组归并为较少的有序段，再做最后一轮归并
+
+struct ExtSortOptions {
+    // 排序使用的内存上限（字节）
+    std::size_t memory_bytes = std::size_t(256) << 20;
+    // 存放临时文件的目录，临时文件创建后立即删除，进程退出时自动回收
+    std::string temp_dir = "/tmp";
+    // 排序线程数，0 表示硬件线程数
+    unsigned threads = 0;
+    // 为 true 时在标准错误输出各阶段的统计信息
+    bool verbose = false;
+};
+
+// 把 input 排序后写入 output，input 与 output 可以是同一个文件；失败时抛出 std::runtime_error
+void externalSort(const std::string &input, const std::string &output, const ExtSortOptions &options);
+
+#endif
@@ -0,0 +1,62 @@
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include "extsort.hpp"
+
+static void usage(const char* prog) {
+    std::fprintf(stderr,
+                 "usage: %s [-m MiB] [-T tmpdir] [-j threads] [-v] input output\n"
+                 "  对 int32 二进制文件排序\n"
+                 "  -m  内存预算（MiB，默认 256）\n"
+                 "  -T  临时文件目录（默认 $TMPDIR 或 /tmp）\n"
+                 "  -j  排序线程数（默认硬件线程数）\n"
+                 "  -v  输出各阶段的统计信息\n",
+                 prog);
+}
+
+int main(int argc, char* argv[]) {
+    ExtSortOptions options;
+    if (const char* tmp = std::getenv("TMPDIR")) {
+        options.temp_dir = tmp;
+    }
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:T:j:vh")) != -1) {
+        switch (opt) {
+            case 'm': {
+                long mib = std::atol(optarg);
+                if (mib <= 0) {
+                    std::fprintf(stderr, "%s: invalid memory budget: %s\n", argv[0], optarg);
+                    return 2;
+                }
+                options.memory_bytes = (size_t)mib << 20;
+                break;
+            }
+            case 'T':
+                options.temp_dir = optarg;
+                break;
+            case 'j':
+                options.threads = (unsigned)std::atoi(optarg);
+                break;
+            case 'v':
+                options.verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        externalSort(argv[optind], argv[optind + 1], options);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+#ifndef PARALLELSORT_HPP
+#define PARALLELSORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include "pdqsort.hpp"
+#include "taskpool.hpp"
+
+// 多线程排序：把区间切成若干块并行地用 pdqSort 排序，再逐轮两两归并
+// 每次归并按输出位置切成多段，用二分查找确定每段在两个输入中的起点，各段并行归并
+// 任务由工作窃取线程池调度，块排序较慢的线程不会拖住其它线程
+namespace parallelsort_detail {
+
+// 小于该长度时直接顺序排序
+const std::size_t sequential_threshold = std::size_t(1) << 16;
+// 并行归并时每段的最小长度
+const std::size_t min_merge_grain = std::size_t(1) << 14;
+
+// 在 a、b 合并后的前 k 个元素中，来自 a 的元素个数；相等元素 a 在前，与 std::merge 一致
+template <class It1, class It2, class Compare>
+std::size_t co_rank(std::size_t k, It1 a, std::size_t na, It2 b, std::size_t nb, Compare comp) {
+    std::size_t lo = k > nb ? k - nb : 0;
+    std::size_t hi = std::min(k, na);
+    while (lo < hi) {
+        std::size_t i = lo + (hi - lo) / 2;
+        std::size_t j = k - i;
+        if (comp(b[j - 1], a[i])) {
+            hi = i;
+        } else {
+            lo = i + 1;
+        }
+    }
+    return lo;
+}
+
+// 一轮归并：把 src 中相邻的两个有序段归并到 dst 的相同位置，runs 为各段的起点（最后一个元素为总长度）
+template <class SrcIt, class DstIt, class Compare>
+void merge_round(TaskPool &pool, SrcIt src, DstIt dst, const std::vector<std::size_t> &runs, std::size_t grain,
+                 Compare comp) {
+    TaskGroup group;
+    for (std::size_t r = 0; r + 1 < runs.size(); r += 2) {
+        std::size_t begin = runs[r], mid = runs[r + 1];
+        std::size_t end = r + 2 < runs.size() ? runs[r + 2] : mid;
+        // 落单的最后一段直接复制
+        if (mid == end) {
+            pool.run(group, [=] { std::move(src + begin, src + end, dst + begin); });
+            continue;
+        }
+        std::size_t na = mid - begin, nb = end - mid;
+        for (std::size_t k0 = 0; k0 < na + nb; k0 += grain) {
+            std::size_t k1 = std::min(k0 + grain, na + nb);
+            pool.run(group, [=] {
+                SrcIt a = src + begin, b = src + mid;
+                std::size_t i0 = co_rank(k0, a, na, b, nb, comp);
+                std::size_t i1 = co_rank(k1, a, na, b, nb, comp);
+                std::merge(std::make_move_iterator(a + i0), std::make_move_iterator(a + i1),
+                           std::make_move_iterator(b + (k0 - i0)), std::make_move_iterator(b + (k1 - i1)),
+                           dst + begin + k0, comp);
+            });
+        }
+    }
+    pool.wait(group);
+}
+
+}  // namespace parallelsort_detail
+
+// 用 threads 个线程（0 表示硬件线程数）按 comp 排序 [begin, end)，结果与顺序排序一致，不稳定
+template <class Iter, class Compare>
+void parallelSort(Iter begin, Iter end, unsigned threads, Compare comp) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    using namespace parallelsort_detail;
+
+    // 先判断规模：hardware_concurrency 每次调用都要读 sysfs，小区间不值得
+    std::size_t n = end - begin;
+    if (n < sequential_threshold) {
+        pdqSort(begin, end, comp);
+        return;
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1) {
+        pdqSort(begin, end, comp);
+        return;
+    }
+
+    TaskPool pool(threads);
+
+    // 切成 threads 的若干倍块，便于工作窃取平衡负载
+    std::size_t chunks = std::min<std::size_t>(threads * 4, n / (sequential_threshold / 4));
+    std::vector<std::size_t> runs;
+    for (std::size_t c = 0; c < chunks; ++c) {
+        runs.push_back(n * c / chunks);
+    }
+    runs.push_back(n);
+
+    TaskGroup group;
+    for (std::size_t c = 0; c < chunks; ++c) {
+        Iter first = begin + runs[c], last = begin + runs[c + 1];
+        pool.run(group, [=] { pdqSort(first, last, comp); });
+    }
+    pool.wait(group);
+
+    // 在原数组和辅助数组之间来回归并，直到只剩一个有序段
+    std::vector<T> buf(n);
+    bool in_buf = false;
+    std::size_t grain = std::max(min_merge_grain, n / (threads * 4));
+    while (runs.size() > 2) {
+        if (in_buf) {
+            merge_round(pool, buf.begin(), begin, runs, grain, comp);
+        } else {
+            merge_round(pool, begin, buf.begin(), runs, grain, comp);
+        }
+        in_buf = !in_buf;
+        std::vector<std::size_t> merged;
+        for (std::size_t r = 0; r < runs.size(); r += 2) {
+            merged.push_back(runs[r]);
+        }
+        if (merged.back() != n) {
+            merged.push_back(n);
+        }
+        runs.swap(merged);
+    }
+
+    if (in_buf) {
+        TaskGroup copy;
+        for (std::size_t k = 0; k < n; k += grain) {
+            std::size_t k1 = std::min(k + grain, n);
+            pool.run(copy, [&buf, begin, k, k1] { std::move(buf.begin() + k, buf.begin() + k1, begin + k); });
+        }
+        pool.wait(copy);
+    }
+}
+
+template <class Iter>
+void parallelSort(Iter begin, Iter end, unsigned threads = 0) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    parallelSort(begin, end, threads, std::less<T>());
+}
+
+#endif
@@ -0,0 +1,450 @@
+#ifndef PDQSORT_HPP
+#define PDQSORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "simdsort.hpp"
+
+// pattern-defeating quicksort（pdqsort）
+// 小区间用插入排序；划分严重不平衡的次数超过 log2(n) 时退化为堆排序，保证 O(n log n)
+// 检测到已有序的区间时提前结束；算术类型配合 std::less/std::greater 时使用无分支的块划分
+// 连续存储的 int32/float 按 std::less 排序时，小区间交给 SIMD 排序网络（见 simdsort.hpp）
+// 参考：Orson Peters, "Pattern-defeating Quicksort", 2021
+namespace pdqsort_detail {
+
+// 小于该长度的区间使用插入排序
+const std::ptrdiff_t insertion_sort_threshold = 24;
+// 使用 SIMD 排序网络时小区间的阈值，不能超过 simd_sort_max
+const std::ptrdiff_t simd_sort_threshold = 48;
+// 大于该长度的区间用九数取中选主元
+const std::ptrdiff_t ninther_threshold = 128;
+// 部分插入排序最多移动的元素个数，超过即放弃
+const std::size_t partial_insertion_sort_limit = 8;
+// 无分支划分每块的元素个数
+const std::size_t block_size = 64;
+const std::size_t cacheline_size = 64;
+
+template <class T>
+struct is_default_compare : std::false_type {};
+template <class T>
+struct is_default_compare<std::less<T> > : std::true_type {};
+template <class T>
+struct is_default_compare<std::greater<T> > : std::true_type {};
+
+inline int log2(std::size_t n) {
+    int log = 0;
+    while (n >>= 1) {
+        ++log;
+    }
+    return log;
+}
+
+// 有边界检查的插入排序
+template <class Iter, class Compare>
+inline void insertion_sort(Iter begin, Iter end, Compare comp) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    if (begin == end) {
+        return;
+    }
+    for (Iter cur = begin + 1; cur != end; ++cur) {
+        Iter sift = cur;
+        Iter sift_1 = cur - 1;
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// 无边界检查的插入排序，要求 *(begin - 1) 不大于区间内的任何元素
+template <class Iter, class Compare>
+inline void unguarded_insertion_sort(Iter begin, Iter end, Compare comp) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    if (begin == end) {
+        return;
+    }
+    for (Iter cur = begin + 1; cur != end; ++cur) {
+        Iter sift = cur;
+        Iter sift_1 = cur - 1;
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// 尝试用插入排序完成排序，移动的元素超过 partial_insertion_sort_limit 时返回 false
+template <class Iter, class Compare>
+inline bool partial_insertion_sort(Iter begin, Iter end, Compare comp) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    if (begin == end) {
+        return true;
+    }
+    std::size_t limit = 0;
+    for (Iter cur = begin + 1; cur != end; ++cur) {
+        Iter sift = cur;
+        Iter sift_1 = cur - 1;
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+            limit += cur - sift;
+        }
+        if (limit > partial_insertion_sort_limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Iter, class Compare>
+inline void sort2(Iter a, Iter b, Compare comp) {
+    if (comp(*b, *a)) {
+        std::iter_swap(a, b);
+    }
+}
+
+template <class Iter, class Compare>
+inline void sort3(Iter a, Iter b, Iter c, Compare comp) {
+    sort2(a, b, comp);
+    sort2(b, c, comp);
+    sort2(a, b, comp);
+}
+
+template <class T>
+inline T *align_cacheline(T *p) {
+    std::uintptr_t ip = reinterpret_cast<std::uintptr_t>(p);
+    ip = (ip + cacheline_size - 1) & ~(std::uintptr_t)(cacheline_size - 1);
+    return reinterpret_cast<T *>(ip);
+}
+
+// 交换块划分中记录下的错位元素；两侧个数相同时用循环移动代替逐对交换
+template <class Iter>
+inline void swap_offsets(Iter first, Iter last, unsigned char *offsets_l, unsigned char *offsets_r,
+                         std::size_t num, bool use_swaps) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    if (use_swaps) {
+        for (std::size_t i = 0; i < num; ++i) {
+            std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+        }
+    } else if (num > 0) {
+        Iter l = first + offsets_l[0];
+        Iter r = last - offsets_r[0];
+        T tmp(std::move(*l));
+        *l = std::move(*r);
+        for (std::size_t i = 1; i < num; ++i) {
+            l = first + offsets_l[i];
+            *r = std::move(*l);
+            r = last - offsets_r[i];
+            *l = std::move(*r);
+        }
+        *r = std::move(tmp);
+    }
+}
+
+// 以 *begin 为主元划分 [begin, end)，与主元相等的元素放在右侧
+// 返回主元的最终位置，以及划分前区间是否已经满足划分条件
+template <class Iter, class Compare>
+inline std::pair<Iter, bool> partition_right(Iter begin, Iter end, Compare comp) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    T pivot(std::move(*begin));
+    Iter first = begin;
+    Iter last = end;
+
+    // 主元是三数取中的结果，左侧一定能找到不小于主元的元素作为哨兵
+    while (comp(*++first, pivot)) {
+    }
+    if (first - 1 == begin) {
+        while (first < last && !comp(*--last, pivot)) {
+        }
+    } else {
+        while (!comp(*--last, pivot)) {
+        }
+    }
+
+    bool already_partitioned = first >= last;
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(*++first, pivot)) {
+        }
+        while (!comp(*--last, pivot)) {
+        }
+    }
+
+    Iter pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+// partition_right 的无分支版本（BlockQuicksort）：
+// 先把一块内放错侧的元素下标记录到缓冲区，再成批交换，比较结果不参与分支，避免分支预测失败
+template <class Iter, class Compare>
+inline std::pair<Iter, bool> partition_right_branchless(Iter begin, Iter end, Compare comp) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    T pivot(std::move(*begin));
+    Iter first = begin;
+    Iter last = end;
+
+    while (comp(*++first, pivot)) {
+    }
+    if (first - 1 == begin) {
+        while (first < last && !comp(*--last, pivot)) {
+        }
+    } else {
+        while (!comp(*--last, pivot)) {
+        }
+    }
+
+    bool already_partitioned = first >= last;
+    if (!already_partitioned) {
+        std::iter_swap(first, last);
+        ++first;
+    }
+
+    unsigned char offsets_l_storage[block_size + cacheline_size];
+    unsigned char offsets_r_storage[block_size + cacheline_size];
+    unsigned char *offsets_l = align_cacheline(offsets_l_storage);
+    unsigned char *offsets_r = align_cacheline(offsets_r_storage);
+    Iter offsets_l_base = first;
+    Iter offsets_r_base = last;
+    std::size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+    while (first < last) {
+        // 决定本轮两侧各扫描多少个元素
+        std::size_t num_unknown = last - first;
+        std::size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+        std::size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+
+        if (left_split >= block_size) {
+            left_split = block_size;
+        }
+        for (std::size_t i = 0; i < left_split;) {
+            offsets_l[num_l] = (unsigned char)i++;
+            num_l += !comp(*first, pivot);
+            ++first;
+        }
+
+        if (right_split >= block_size) {
+            right_split = block_size;
+        }
+        for (std::size_t i = 0; i < right_split;) {
+            offsets_r[num_r] = (unsigned char)++i;
+            num_r += comp(*--last, pivot);
+        }
+
+        std::size_t num = std::min(num_l, num_r);
+        swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, num, num_l == num_r);
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+
+        if (num_l == 0) {
+            start_l = 0;
+            offsets_l_base = first;
+        }
+        if (num_r == 0) {
+            start_r = 0;
+            offsets_r_base = last;
+        }
+    }
+
+    // 处理剩余的错位元素
+    if (num_l) {
+        offsets_l += start_l;
+        while (num_l--) {
+            std::iter_swap(offsets_l_base + offsets_l[num_l], --last);
+        }
+        first = last;
+    }
+    if (num_r) {
+        offsets_r += start_r;
+        while (num_r--) {
+            std::iter_swap(offsets_r_base - offsets_r[num_r], first);
+            ++first;
+        }
+        last = first;
+    }
+
+    Iter pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+// 以 *begin 为主元划分 [begin, end)，与主元相等的元素放在左侧
+// 用于大量重复元素：所有与主元相等的元素一次划分后即不再参与排序
+template <class Iter, class Compare>
+inline Iter partition_left(Iter begin, Iter end, Compare comp) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    T pivot(std::move(*begin));
+    Iter first = begin;
+    Iter last = end;
+
+    while (comp(pivot, *--last)) {
+    }
+    if (last + 1 == end) {
+        while (first < last && !comp(pivot, *++first)) {
+        }
+    } else {
+        while (!comp(pivot, *++first)) {
+        }
+    }
+
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(pivot, *--last)) {
+        }
+        while (!comp(pivot, *++first)) {
+        }
+    }
+
+    Iter pivot_pos = last;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return pivot_pos;
+}
+
+// 小区间是否交给 sortSmall
+template <class Iter, class Compare>
+struct use_simd_sort
+    : std::integral_constant<bool, is_simd_sortable<Iter>::value &&
+                                       std::is_same<Compare, std::less<typename std::iterator_traits<
+                                                                 Iter>::value_type> >::value> {};
+
+template <class Iter, class Compare>
+inline void small_sort(Iter begin, Iter end, Compare comp, bool leftmost, std::false_type) {
+    if (leftmost) {
+        insertion_sort(begin, end, comp);
+    } else {
+        unguarded_insertion_sort(begin, end, comp);
+    }
+}
+
+template <class Iter, class Compare>
+inline void small_sort(Iter begin, Iter end, Compare, bool, std::true_type) {
+    sortSmall(&*begin, end - begin);
+}
+
+// pdqsort 主循环：递归处理左半部分，循环处理右半部分
+// bad_allowed 为还允许出现的严重不平衡划分次数，用完后改用堆排序
+// leftmost 为 false 时 *(begin - 1) 是之前划分的主元，可作为插入排序的哨兵
+template <bool Branchless, class Iter, class Compare>
+inline void pdqsort_loop(Iter begin, Iter end, Compare comp, int bad_allowed, bool leftmost) {
+    typedef typename std::iterator_traits<Iter>::difference_type diff_t;
+    typedef use_simd_sort<Iter, Compare> simd;
+    const diff_t small_threshold = simd::value ? simd_sort_threshold : insertion_sort_threshold;
+
+    while (true) {
+        diff_t size = end - begin;
+
+        if (size < small_threshold) {
+            small_sort(begin, end, comp, leftmost, simd());
+            return;
+        }
+
+        // 选主元并放到 begin 处
+        diff_t s2 = size / 2;
+        if (size > ninther_threshold) {
+            sort3(begin, begin + s2, end - 1, comp);
+            sort3(begin + 1, begin + (s2 - 1), end - 2, comp);
+            sort3(begin + 2, begin + (s2 + 1), end - 3, comp);
+            sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), comp);
+            std::iter_swap(begin, begin + s2);
+        } else {
+            sort3(begin + s2, begin, end - 1, comp);
+        }
+
+        // 主元与左侧的哨兵相等，说明区间内有大量等于主元的元素
+        // 把它们划分到左侧后不再处理
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            begin = partition_left(begin, end, comp) + 1;
+            continue;
+        }
+
+        std::pair<Iter, bool> part_result =
+            Branchless ? partition_right_branchless(begin, end, comp) : partition_right(begin, end, comp);
+        Iter pivot_pos = part_result.first;
+        bool already_partitioned = part_result.second;
+
+        diff_t l_size = pivot_pos - begin;
+        diff_t r_size = end - (pivot_pos + 1);
+        bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+        if (highly_unbalanced) {
+            // 不平衡次数过多，改用堆排序保证最坏情况 O(n log n)
+            if (--bad_allowed == 0) {
+                std::make_heap(begin, end, comp);
+                std::sort_heap(begin, end, comp);
+                return;
+            }
+
+            // 打乱部分元素，破坏可能导致不平衡的输入模式
+            if (l_size >= insertion_sort_threshold) {
+                std::iter_swap(begin, begin + l_size / 4);
+                std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+                if (l_size > ninther_threshold) {
+                    std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+                    std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+                    std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+            if (r_size >= insertion_sort_threshold) {
+                std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                std::iter_swap(end - 1, end - r_size / 4);
+                if (r_size > ninther_threshold) {
+                    std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    std::iter_swap(end - 2, end - (1 + r_size / 4));
+                    std::iter_swap(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else {
+            // 划分前已经有序时，尝试直接用插入排序完成
+            if (already_partitioned && partial_insertion_sort(begin, pivot_pos, comp) &&
+                partial_insertion_sort(pivot_pos + 1, end, comp)) {
+                return;
+            }
+        }
+
+        pdqsort_loop<Branchless>(begin, pivot_pos, comp, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+}  // namespace pdqsort_detail
+
+// 对任意随机访问区间 [begin, end) 按 comp 排序，不稳定
+template <class Iter, class Compare>
+inline void pdqSort(Iter begin, Iter end, Compare comp) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    if (end - begin < 2) {
+        return;
+    }
+    const bool branchless = std::is_arithmetic<T>::value && pdqsort_detail::is_default_compare<Compare>::value;
+    pdqsort_detail::pdqsort_loop<branchless>(begin, end, comp, pdqsort_detail::log2(end - begin), true);
+}
+
+template <class Iter>
+inline void pdqSort(Iter begin, Iter end) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    pdqSort(begin, end, std::less<T>());
+}
+
+#endif
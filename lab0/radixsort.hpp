@@ -0,0 +1,268 @@
+#ifndef RADIXSORT_HPP
+#define RADIXSORT_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "pdqsort.hpp"
+#include "simdsort.hpp"
+
+// 基数排序：整数和浮点数先映射为保序的无符号整数，再按位分段排序
+// 中等规模使用 LSD（低位优先），每段 8 或 11 位，一次预扫描建立所有段的直方图，
+// 所有元素落在同一个桶中的段直接跳过；
+// 超大规模先按最高段做一次 MSD 分桶，再对每个桶做 LSD，使每个桶都能放进缓存
+namespace radix_detail {
+
+// 不超过该长度时使用插入排序
+const std::size_t insertion_threshold = 64;
+// 小于该长度时使用 8 位一段，减少直方图的开销
+const std::size_t small_digit_threshold = 4096;
+// 超过该长度时先做一次 MSD 分桶
+const std::size_t msd_threshold = std::size_t(1) << 22;
+const int max_digit_bits = 11;
+
+// 把键映射为无符号整数，映射后的无符号比较与原类型的比较顺序一致
+template <class T, class Enable = void>
+struct radix_traits;
+
+template <class T>
+struct radix_traits<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type> {
+    typedef T key_type;
+    static key_type encode(T x) { return x; }
+};
+
+// 有符号整数：翻转符号位
+template <class T>
+struct radix_traits<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type> {
+    typedef typename std::make_unsigned<T>::type key_type;
+    static key_type encode(T x) {
+        return (key_type)x ^ ((key_type)1 << (sizeof(T) * CHAR_BIT - 1));
+    }
+};
+
+// IEEE 754 浮点数：负数按位取反，非负数翻转符号位
+template <class T, class U>
+struct float_radix_traits {
+    typedef U key_type;
+    static key_type encode(T x) {
+        U u;
+        std::memcpy(&u, &x, sizeof(u));
+        const U sign = (U)1 << (sizeof(U) * CHAR_BIT - 1);
+        return (u & sign) ? ~u : (u ^ sign);
+    }
+};
+
+template <>
+struct radix_traits<float> : float_radix_traits<float, std::uint32_t> {};
+template <>
+struct radix_traits<double> : float_radix_traits<double, std::uint64_t> {};
+
+template <class T, class Enable = void>
+struct is_radix_sortable : std::false_type {};
+template <class T>
+struct is_radix_sortable<T, typename std::enable_if<(std::is_integral<T>::value && !std::is_same<T, bool>::value) ||
+                                                    std::is_same<T, float>::value ||
+                                                    std::is_same<T, double>::value>::type> : std::true_type {};
+
+// 对元素本身排序时的取键函数
+template <class T>
+struct identity_key {
+    T operator()(const T &x) const { return x; }
+};
+
+// 取出键并映射为无符号整数
+template <class T, class KeyFn>
+struct encoder {
+    typedef typename std::decay<typename std::result_of<KeyFn(const T &)>::type>::type raw_key;
+    typedef typename radix_traits<raw_key>::key_type key_type;
+    KeyFn key_fn;
+    explicit encoder(KeyFn fn) : key_fn(fn) {}
+    key_type operator()(const T &x) const { return radix_traits<raw_key>::encode(key_fn(x)); }
+};
+
+// 按键的插入排序，稳定
+template <class T, class Encode>
+inline void insertion_sort(T *data, std::size_t n, const Encode &enc) {
+    for (std::size_t i = 1; i < n; ++i) {
+        if (enc(data[i]) < enc(data[i - 1])) {
+            T tmp = std::move(data[i]);
+            typename Encode::key_type key = enc(tmp);
+            std::size_t j = i;
+            do {
+                data[j] = std::move(data[j - 1]);
+                --j;
+            } while (j > 0 && key < enc(data[j - 1]));
+            data[j] = std::move(tmp);
+        }
+    }
+}
+
+// 对 src 中 [0, n) 的元素按第 0 到 num_digits - 1 段做 LSD 排序，buf 为同样大小的辅助空间
+// 结果保证写回 src
+template <class T, class Encode>
+void lsd_sort(T *src, T *buf, std::size_t n, const Encode &enc, int digit_bits, int num_digits) {
+    typedef typename Encode::key_type key_type;
+    if (n <= insertion_threshold) {
+        insertion_sort(src, n, enc);
+        return;
+    }
+
+    const std::size_t radix = std::size_t(1) << digit_bits;
+    const key_type mask = (key_type)(radix - 1);
+
+    // 一次扫描建立所有段的直方图
+    std::vector<std::size_t> counts(num_digits * radix, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        key_type key = enc(src[i]);
+        for (int d = 0; d < num_digits; ++d) {
+            counts[d * radix + ((key >> (d * digit_bits)) & mask)]++;
+        }
+    }
+
+    T *from = src, *to = buf;
+    key_type first_key = enc(src[0]);
+    for (int d = 0; d < num_digits; ++d) {
+        std::size_t *count = &counts[d * radix];
+        int shift = d * digit_bits;
+        // 所有元素这一段都相同，跳过
+        if (count[(first_key >> shift) & mask] == n) {
+            continue;
+        }
+        std::size_t sum = 0;
+        for (std::size_t b = 0; b < radix; ++b) {
+            std::size_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            to[count[(enc(from[i]) >> shift) & mask]++] = std::move(from[i]);
+        }
+        std::swap(from, to);
+    }
+
+    if (from != src) {
+        std::move(from, from + n, src);
+    }
+}
+
+// 排序连续存储的 [data, data + n)
+template <class T, class Encode>
+void radix_sort(T *data, std::size_t n, const Encode &enc) {
+    typedef typename Encode::key_type key_type;
+    const int key_bits = sizeof(key_type) * CHAR_BIT;
+    if (n <= insertion_threshold) {
+        insertion_sort(data, n, enc);
+        return;
+    }
+
+    // 已经有序时直接返回；无序的输入通常在开头几个元素就能发现
+    std::size_t run = 1;
+    while (run < n && enc(data[run - 1]) <= enc(data[run])) {
+        ++run;
+    }
+    if (run == n) {
+        return;
+    }
+
+    int digit_bits = (n < small_digit_threshold || key_bits <= 16) ? 8 : max_digit_bits;
+    int num_digits = (key_bits + digit_bits - 1) / digit_bits;
+    std::vector<T> buf(n);
+
+    if (n <= msd_threshold || num_digits == 1) {
+        lsd_sort(data, buf.data(), n, enc, digit_bits, num_digits);
+        return;
+    }
+
+    // MSD：按最高段分桶到 buf，再对每个桶的低位段做 LSD，结果写回 data
+    const int shift = (num_digits - 1) * digit_bits;
+    const std::size_t radix = std::size_t(1) << (key_bits - shift);
+    std::vector<std::size_t> count(radix + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        count[(enc(data[i]) >> shift) + 1]++;
+    }
+    for (std::size_t b = 0; b < radix; ++b) {
+        count[b + 1] += count[b];
+    }
+    std::vector<std::size_t> offset(count.begin(), count.end() - 1);
+    for (std::size_t i = 0; i < n; ++i) {
+        buf[offset[enc(data[i]) >> shift]++] = std::move(data[i]);
+    }
+    for (std::size_t b = 0; b < radix; ++b) {
+        std::size_t begin = count[b], size = count[b + 1] - count[b];
+        if (size == 0) {
+            continue;
+        }
+        lsd_sort(&buf[begin], &data[begin], size, enc, digit_bits, num_digits - 1);
+        std::move(&buf[begin], &buf[begin] + size, &data[begin]);
+    }
+}
+
+// 连续存储的区间直接排序，其余区间先复制到临时数组
+template <class Iter, class Encode>
+void radix_sort_range(Iter begin, Iter end, const Encode &enc, std::true_type) {
+    if (begin != end) {
+        radix_sort(&*begin, end - begin, enc);
+    }
+}
+
+template <class Iter, class Encode>
+void radix_sort_range(Iter begin, Iter end, const Encode &enc, std::false_type) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    std::vector<T> tmp(std::make_move_iterator(begin), std::make_move_iterator(end));
+    radix_sort(tmp.data(), tmp.size(), enc);
+    std::move(tmp.begin(), tmp.end(), begin);
+}
+
+template <class Iter>
+void fast_sort(Iter begin, Iter end, std::true_type);
+template <class Iter>
+void fast_sort(Iter begin, Iter end, std::false_type);
+
+}  // namespace radix_detail
+
+// 按升序排序整数或浮点数区间
+template <class Iter>
+inline void radixSort(Iter begin, Iter end) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    static_assert(radix_detail::is_radix_sortable<T>::value,
+                  "radixSort requires an integral, float or double value type");
+    radix_detail::encoder<T, radix_detail::identity_key<T> > enc((radix_detail::identity_key<T>()));
+    radix_detail::radix_sort_range(begin, end, enc, is_contiguous_iterator<Iter>());
+}
+
+// 按 key(element) 的升序排序任意元素，key 返回整数或浮点数；排序是稳定的
+template <class Iter, class KeyFn>
+inline void radixSortBy(Iter begin, Iter end, KeyFn key) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    radix_detail::encoder<T, KeyFn> enc(key);
+    radix_detail::radix_sort_range(begin, end, enc, is_contiguous_iterator<Iter>());
+}
+
+namespace radix_detail {
+
+template <class Iter>
+void fast_sort(Iter begin, Iter end, std::true_type) {
+    radixSort(begin, end);
+}
+
+template <class Iter>
+void fast_sort(Iter begin, Iter end, std::false_type) {
+    pdqSort(begin, end);
+}
+
+}  // namespace radix_detail
+
+// 在编译期选择排序算法：整数和浮点数使用基数排序，其余类型使用 pdqSort
+template <class Iter>
+inline void fastSort(Iter begin, Iter end) {
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    radix_detail::fast_sort(begin, end, radix_detail::is_radix_sortable<T>());
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "simdsort.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// 标量实现：插入排序
+template <class T>
+void sort_small_scalar(T *data, std::size_t n) {
+    for (std::size_t i = 1; i < n; ++i) {
+        T tmp = data[i];
+        std::size_t j = i;
+        while (j > 0 && tmp < data[j - 1]) {
+            data[j] = data[j - 1];
+            --j;
+        }
+        data[j] = tmp;
+    }
+}
+
+template <class T>
+void merge_scalar(const T *a, std::size_t na, const T *b, std::size_t nb, T *out) {
+    std::merge(a, a + na, b, b + nb, out);
+}
+
+struct Kernels {
+    const char *isa;
+    void (*sort_i32)(std::int32_t *, std::size_t);
+    void (*sort_f32)(float *, std::size_t);
+    void (*merge_i32)(const std::int32_t *, std::size_t, const std::int32_t *, std::size_t, std::int32_t *);
+    void (*merge_f32)(const float *, std::size_t, const float *, std::size_t, float *);
+};
+
+// 按 CPU 支持的指令集选择实现，环境变量 SIMDSORT_ISA 可以强制使用较低的指令集
+Kernels select_kernels() {
+    Kernels scalar = {"scalar", sort_small_scalar<std::int32_t>, sort_small_scalar<float>,
+                      merge_scalar<std::int32_t>, merge_scalar<float>};
+    Kernels sse41 = {"sse4.1", simdsort_detail::sort_small_sse41, simdsort_detail::sort_small_sse41,
+                     simdsort_detail::merge_sse41, simdsort_detail::merge_sse41};
+    Kernels avx2 = {"avx2", simdsort_detail::sort_small_avx2, simdsort_detail::sort_small_avx2,
+                    simdsort_detail::merge_avx2, simdsort_detail::merge_avx2};
+
+    const char *force = std::getenv("SIMDSORT_ISA");
+    bool allow_avx2 = !force || std::strcmp(force, "avx2") == 0;
+    bool allow_sse41 = allow_avx2 || std::strcmp(force, "sse4.1") == 0;
+
+    __builtin_cpu_init();
+    if (allow_avx2 && __builtin_cpu_supports("avx2")) {
+        return avx2;
+    }
+    if (allow_sse41 && __builtin_cpu_supports("sse4.1")) {
+        return sse41;
+    }
+    return scalar;
+}
+
+const Kernels kernels = select_kernels();
+
+}  // namespace
+
+void sortSmall(std::int32_t *data, std::size_t n) {
+    if (n > simd_sort_max) {
+        std::sort(data, data + n);
+        return;
+    }
+    kernels.sort_i32(data, n);
+}
+
+void sortSmall(float *data, std::size_t n) {
+    if (n > simd_sort_max) {
+        std::sort(data, data + n);
+        return;
+    }
+    kernels.sort_f32(data, n);
+}
+
+void sortSmallBatch(std::int32_t *data, const std::size_t *offsets, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        sortSmall(data + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+}
+
+void sortSmallBatch(float *data, const std::size_t *offsets, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        sortSmall(data + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+}
+
+void mergeSorted(const std::int32_t *a, std::size_t na, const std::int32_t *b, std::size_t nb, std::int32_t *out) {
+    kernels.merge_i32(a, na, b, nb, out);
+}
+
+void mergeSorted(const float *a, std::size_t na, const float *b, std::size_t nb, float *out) {
+    kernels.merge_f32(a, na, b, nb, out);
+}
+
+const char *simdSortIsa() {
+    return kernels.isa;
+}
@@ -0,0 +1,65 @@
+#ifndef SIMDSORT_HPP
+#define SIMDSORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+// 小块排序的 SIMD 排序网络
+// 数据装入若干个向量寄存器，先在每个寄存器内用双调排序网络排序，再在寄存器之间逐轮双调归并，
+// 整个过程只有 min/max/置换/混合指令，没有依赖数据的分支
+// 运行时检测 CPU：支持 AVX2 时每个寄存器 8 个元素，只支持 SSE4.1 时 4 个元素，否则使用标量插入排序
+// 浮点数不能包含 NaN
+
+// 排序不超过 64 个元素的数组，更长的数组退化为 std::sort
+void sortSmall(std::int32_t *data, std::size_t n);
+void sortSmall(float *data, std::size_t n);
+
+// 批量排序多个互相独立的小数组，第 i 个数组为 data[offsets[i], offsets[i + 1])
+void sortSmallBatch(std::int32_t *data, const std::size_t *offsets, std::size_t count);
+void sortSmallBatch(float *data, const std::size_t *offsets, std::size_t count);
+
+// 用双调归并网络把两个有序数组归并到 out，out 不能与输入重叠
+void mergeSorted(const std::int32_t *a, std::size_t na, const std::int32_t *b, std::size_t nb, std::int32_t *out);
+void mergeSorted(const float *a, std::size_t na, const float *b, std::size_t nb, float *out);
+
+// 当前使用的指令集："avx2"、"sse4.1" 或 "scalar"
+// 可以用环境变量 SIMDSORT_ISA 强制使用较低的指令集，便于对比
+const char *simdSortIsa();
+
+// sortSmall 能处理的最大长度
+const std::size_t simd_sort_max = 64;
+
+// 指向连续存储的迭代器：指针或 std::vector 的迭代器
+template <class Iter>
+struct is_contiguous_iterator
+    : std::integral_constant<bool, std::is_pointer<Iter>::value ||
+                                       std::is_same<Iter, typename std::vector<typename std::iterator_traits<
+                                                              Iter>::value_type>::iterator>::value> {};
+
+// 可以直接交给 sortSmall 的区间：连续存储的 int32/float
+template <class Iter>
+struct is_simd_sortable
+    : std::integral_constant<bool, is_contiguous_iterator<Iter>::value &&
+                                       (std::is_same<typename std::iterator_traits<Iter>::value_type,
+                                                     std::int32_t>::value ||
+                                        std::is_same<typename std::iterator_traits<Iter>::value_type, float>::value)> {};
+
+namespace simdsort_detail {
+
+// 各指令集的实现，分别在以对应指令集编译的源文件中
+void sort_small_avx2(std::int32_t *data, std::size_t n);
+void sort_small_avx2(float *data, std::size_t n);
+void merge_avx2(const std::int32_t *a, std::size_t na, const std::int32_t *b, std::size_t nb, std::int32_t *out);
+void merge_avx2(const float *a, std::size_t na, const float *b, std::size_t nb, float *out);
+
+void sort_small_sse41(std::int32_t *data, std::size_t n);
+void sort_small_sse41(float *data, std::size_t n);
+void merge_sse41(const std::int32_t *a, std::size_t na, const std::int32_t *b, std::size_t nb, std::int32_t *out);
+void merge_sse41(const float *a, std::size_t na, const float *b, std::size_t nb, float *out);
+
+}  // namespace simdsort_detail
+
+#endif
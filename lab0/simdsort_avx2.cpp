@@ -0,0 +1,74 @@
+// 本文件以 -mavx2 编译，只有在 CPU 支持 AVX2 时才会被调用
+#include <immintrin.h>
+#include <cstdint>
+#include <limits>
+#include "simdsort.hpp"
+#include "simdsort_kernels.hpp"
+
+namespace {
+
+// 第 i 个元素取第 i ^ X 个元素的置换下标
+template <int X>
+inline __m256i xor_indices() {
+    return _mm256_setr_epi32(0 ^ X, 1 ^ X, 2 ^ X, 3 ^ X, 4 ^ X, 5 ^ X, 6 ^ X, 7 ^ X);
+}
+
+struct Avx2Int32 {
+    typedef std::int32_t value_type;
+    typedef __m256i vec;
+    static const int lanes = 8;
+
+    static vec loadu(const value_type *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    static void storeu(value_type *p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    static vec lt(vec a, vec b) { return _mm256_cmpgt_epi32(b, a); }
+    static vec select(vec a, vec b, vec m) { return _mm256_blendv_epi8(a, b, m); }
+    template <int X>
+    static vec permute_xor(vec v) {
+        return _mm256_permutevar8x32_epi32(v, xor_indices<X>());
+    }
+    template <int M>
+    static vec blend(vec a, vec b) { return _mm256_blend_epi32(a, b, M); }
+    static vec reverse(vec v) { return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+    static value_type max_value() { return std::numeric_limits<value_type>::max(); }
+};
+
+struct Avx2Float {
+    typedef float value_type;
+    typedef __m256 vec;
+    static const int lanes = 8;
+
+    static vec loadu(const value_type *p) { return _mm256_loadu_ps(p); }
+    static void storeu(value_type *p, vec v) { _mm256_storeu_ps(p, v); }
+    static vec lt(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static vec select(vec a, vec b, vec m) { return _mm256_blendv_ps(a, b, m); }
+    template <int X>
+    static vec permute_xor(vec v) {
+        return _mm256_permutevar8x32_ps(v, xor_indices<X>());
+    }
+    template <int M>
+    static vec blend(vec a, vec b) { return _mm256_blend_ps(a, b, M); }
+    static vec reverse(vec v) { return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+    static value_type max_value() { return std::numeric_limits<value_type>::infinity(); }
+};
+
+}  // namespace
+
+namespace simdsort_detail {
+
+void sort_small_avx2(std::int32_t *data, std::size_t n) {
+    simdsort_kernels::sort_small<Avx2Int32>(data, n);
+}
+
+void sort_small_avx2(float *data, std::size_t n) {
+    simdsort_kernels::sort_small<Avx2Float>(data, n);
+}
+
+void merge_avx2(const std::int32_t *a, std::size_t na, const std::int32_t *b, std::size_t nb, std::int32_t *out) {
+    simdsort_kernels::merge<Avx2Int32>(a, na, b, nb, out);
+}
+
+void merge_avx2(const float *a, std::size_t na, const float *b, std::size_t nb, float *out) {
+    simdsort_kernels::merge<Avx2Float>(a, na, b, nb, out);
+}
+
+}  // namespace simdsort_detail
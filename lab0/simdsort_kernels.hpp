@@ -0,0 +1,229 @@
+#ifndef SIMDSORT_KERNELS_HPP
+#define SIMDSORT_KERNELS_HPP
+
+#include <cstddef>
+#include <cstring>
+
+// SIMD 排序网络的通用实现，由 simdsort_avx2.cpp 和 simdsort_sse41.cpp 以不同的向量类型 V 实例化
+// V 需要提供：
+//   value_type、vec、lanes
+//   loadu/storeu、reverse（寄存器内逆序）
+//   lt(a, b)：a < b 的元素对应的掩码；select(a, b, m)：掩码为真的元素取 b，否则取 a
+//   permute_xor<X>：第 i 个元素换成第 i ^ X 个元素
+//   blend<M>：掩码第 i 位为 1 时取第二个参数的第 i 个元素，否则取第一个参数的
+//   max_value：补齐不满的寄存器用的最大值
+// 比较交换都由同一个 lt 掩码选择元素，不用 min/max：浮点 min/max 在两数相等时都返回第二个参数，
+// -0.0 与 +0.0 比较时会丢掉一个、复制另一个，结果不再是输入的排列
+// 各源文件中的 V 定义在匿名命名空间中，实例化结果不会在不同指令集的目标文件之间混用
+// 因此这里的函数都以 V 为模板参数，也不调用 std::merge 等标准库模板：
+// 它们按 int/float 实例化后是弱符号，链接器可能把以 AVX2 编译的版本交给不支持 AVX2 的调用者
+namespace simdsort_kernels {
+
+// x 的最高位
+constexpr int high_bit(int x) {
+    return x <= 1 ? x : 2 * high_bit(x / 2);
+}
+
+// 与 i ^ x 配对时，i 是较大下标的那些元素对应的掩码位
+constexpr int upper_mask(int x, int lanes, int i = 0) {
+    return i == lanes ? 0 : (((i & high_bit(x)) ? (1 << i) : 0) | upper_mask(x, lanes, i + 1));
+}
+
+// 两个寄存器逐元素比较交换，相等时保持原样
+template <class V>
+inline void minmax(typename V::vec &a, typename V::vec &b) {
+    typename V::vec m = V::lt(b, a);
+    typename V::vec lo = V::select(a, b, m);
+    b = V::select(b, a, m);
+    a = lo;
+}
+
+// 寄存器内的比较交换：第 i 个与第 i ^ X 个元素比较，较小的放在下标较小的位置
+// 每一对的两个元素用同一个比较结果（较大下标的元素是否小于较小下标的元素）决定是否交换
+template <class V, int X>
+inline typename V::vec compare_exchange(typename V::vec v) {
+    typename V::vec p = V::template permute_xor<X>(v);
+    typename V::vec swap = V::template blend<upper_mask(X, V::lanes)>(V::lt(p, v), V::lt(v, p));
+    return V::select(v, p, swap);
+}
+
+template <class V, int Lanes = V::lanes>
+struct network;
+
+// 8 个元素的双调排序网络：每次归并先与镜像位置比较，再逐级减半
+template <class V>
+struct network<V, 8> {
+    typedef typename V::vec vec;
+    static vec sort(vec v) {
+        v = compare_exchange<V, 1>(v);
+        v = compare_exchange<V, 3>(v);
+        v = compare_exchange<V, 1>(v);
+        v = compare_exchange<V, 7>(v);
+        v = compare_exchange<V, 2>(v);
+        v = compare_exchange<V, 1>(v);
+        return v;
+    }
+    // 把双调序列整理为有序序列
+    static vec clean(vec v) {
+        v = compare_exchange<V, 4>(v);
+        v = compare_exchange<V, 2>(v);
+        v = compare_exchange<V, 1>(v);
+        return v;
+    }
+};
+
+template <class V>
+struct network<V, 4> {
+    typedef typename V::vec vec;
+    static vec sort(vec v) {
+        v = compare_exchange<V, 1>(v);
+        v = compare_exchange<V, 3>(v);
+        v = compare_exchange<V, 1>(v);
+        return v;
+    }
+    static vec clean(vec v) {
+        v = compare_exchange<V, 2>(v);
+        v = compare_exchange<V, 1>(v);
+        return v;
+    }
+};
+
+// 把 v[0, w) 和 v[w, 2w) 两组各自有序的寄存器归并为有序的 v[0, 2w)
+// 第二组整体逆序后与第一组构成双调序列，再做寄存器之间和寄存器内部的半清理
+template <class V>
+inline void merge_registers(typename V::vec *v, std::size_t w) {
+    for (std::size_t i = 0; i < w / 2; ++i) {
+        typename V::vec t = v[w + i];
+        v[w + i] = v[2 * w - 1 - i];
+        v[2 * w - 1 - i] = t;
+    }
+    for (std::size_t i = w; i < 2 * w; ++i) {
+        v[i] = V::reverse(v[i]);
+    }
+    for (std::size_t d = w; d >= 1; d /= 2) {
+        for (std::size_t i = 0; i < 2 * w; ++i) {
+            if ((i & d) == 0) {
+                minmax<V>(v[i], v[i + d]);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < 2 * w; ++i) {
+        v[i] = network<V>::clean(v[i]);
+    }
+}
+
+// 排序不超过 64 个元素：补齐到 2 的幂个寄存器，寄存器内排序后逐轮归并
+template <class V>
+void sort_small(typename V::value_type *data, std::size_t n) {
+    typedef typename V::value_type T;
+    const std::size_t lanes = V::lanes;
+    const std::size_t max_elems = 64;
+    if (n <= 1) {
+        return;
+    }
+
+    std::size_t regs = 1;
+    while (regs * lanes < n) {
+        regs *= 2;
+    }
+    T buf[max_elems];
+    std::memcpy(buf, data, n * sizeof(T));
+    for (std::size_t i = n; i < regs * lanes; ++i) {
+        buf[i] = V::max_value();
+    }
+
+    typename V::vec v[max_elems / lanes];
+    for (std::size_t r = 0; r < regs; ++r) {
+        v[r] = network<V>::sort(V::loadu(buf + r * lanes));
+    }
+    for (std::size_t w = 1; w < regs; w *= 2) {
+        for (std::size_t s = 0; s < regs; s += 2 * w) {
+            merge_registers<V>(v + s, w);
+        }
+    }
+    for (std::size_t r = 0; r < regs; ++r) {
+        V::storeu(buf + r * lanes, v[r]);
+    }
+    std::memcpy(data, buf, n * sizeof(T));
+}
+
+// 标量归并，相等元素 a 在前
+template <class V>
+typename V::value_type *merge_scalar(const typename V::value_type *a, std::size_t na,
+                                     const typename V::value_type *b, std::size_t nb, typename V::value_type *out) {
+    std::size_t ia = 0, ib = 0;
+    while (ia < na && ib < nb) {
+        *out++ = b[ib] < a[ia] ? b[ib++] : a[ia++];
+    }
+    while (ia < na) {
+        *out++ = a[ia++];
+    }
+    while (ib < nb) {
+        *out++ = b[ib++];
+    }
+    return out;
+}
+
+// 三路归并，用于处理向量归并剩下的尾部
+template <class V>
+void merge3(const typename V::value_type *a, std::size_t na, const typename V::value_type *b, std::size_t nb,
+            const typename V::value_type *c, std::size_t nc, typename V::value_type *out) {
+    std::size_t ia = 0, ib = 0, ic = 0;
+    while (ic < nc) {
+        if (ia < na && a[ia] <= c[ic] && (ib >= nb || a[ia] <= b[ib])) {
+            *out++ = a[ia++];
+        } else if (ib < nb && b[ib] <= c[ic]) {
+            *out++ = b[ib++];
+        } else {
+            *out++ = c[ic++];
+        }
+    }
+    merge_scalar<V>(a + ia, na - ia, b + ib, nb - ib, out);
+}
+
+// 向量化归并：每次把一个寄存器的新元素与上一轮剩下的较大一半做双调归并，输出较小的一半
+// 下一块总是从头部元素较小的输入中取，保证已输出的元素不大于所有剩余元素
+template <class V>
+void merge(const typename V::value_type *a, std::size_t na, const typename V::value_type *b, std::size_t nb,
+           typename V::value_type *out) {
+    typedef typename V::value_type T;
+    typedef typename V::vec vec;
+    const std::size_t lanes = V::lanes;
+    if (na < lanes || nb < lanes) {
+        merge_scalar<V>(a, na, b, nb, out);
+        return;
+    }
+
+    vec va = V::loadu(a), vb = V::loadu(b);
+    std::size_t ia = lanes, ib = lanes;
+    while (true) {
+        vb = V::reverse(vb);
+        minmax<V>(va, vb);
+        V::storeu(out, network<V>::clean(va));
+        out += lanes;
+        vb = network<V>::clean(vb);
+
+        bool take_a = ia < na && (ib >= nb || a[ia] <= b[ib]);
+        if (take_a) {
+            if (ia + lanes > na) {
+                break;
+            }
+            va = V::loadu(a + ia);
+            ia += lanes;
+        } else {
+            if (ib + lanes > nb) {
+                break;
+            }
+            va = V::loadu(b + ib);
+            ib += lanes;
+        }
+    }
+
+    T tail[V::lanes];
+    V::storeu(tail, vb);
+    merge3<V>(a + ia, na - ia, b + ib, nb - ib, tail, lanes, out);
+}
+
+}  // namespace simdsort_kernels
+
+#endif
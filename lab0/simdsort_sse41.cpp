@@ -0,0 +1,76 @@
+// 本文件以 -msse4.1 编译，只有在 CPU 支持 SSE4.1 时才会被调用
+#include <smmintrin.h>
+#include <cstdint>
+#include <limits>
+#include "simdsort.hpp"
+#include "simdsort_kernels.hpp"
+
+namespace {
+
+// 第 i 个元素取第 i ^ X 个元素的 shuffle 立即数
+template <int X>
+struct shuffle_xor {
+    static const int value = (0 ^ X) | ((1 ^ X) << 2) | ((2 ^ X) << 4) | ((3 ^ X) << 6);
+};
+
+// 把每 32 位一位的掩码扩展为 _mm_blend_epi16 使用的每 16 位一位的掩码
+template <int M>
+struct blend16_mask {
+    static const int value = ((M & 1) ? 0x03 : 0) | ((M & 2) ? 0x0C : 0) | ((M & 4) ? 0x30 : 0) | ((M & 8) ? 0xC0 : 0);
+};
+
+struct Sse41Int32 {
+    typedef std::int32_t value_type;
+    typedef __m128i vec;
+    static const int lanes = 4;
+
+    static vec loadu(const value_type *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+    static void storeu(value_type *p, vec v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+    static vec lt(vec a, vec b) { return _mm_cmplt_epi32(a, b); }
+    static vec select(vec a, vec b, vec m) { return _mm_blendv_epi8(a, b, m); }
+    template <int X>
+    static vec permute_xor(vec v) { return _mm_shuffle_epi32(v, shuffle_xor<X>::value); }
+    template <int M>
+    static vec blend(vec a, vec b) { return _mm_blend_epi16(a, b, blend16_mask<M>::value); }
+    static vec reverse(vec v) { return _mm_shuffle_epi32(v, 0x1B); }
+    static value_type max_value() { return std::numeric_limits<value_type>::max(); }
+};
+
+struct Sse41Float {
+    typedef float value_type;
+    typedef __m128 vec;
+    static const int lanes = 4;
+
+    static vec loadu(const value_type *p) { return _mm_loadu_ps(p); }
+    static void storeu(value_type *p, vec v) { _mm_storeu_ps(p, v); }
+    static vec lt(vec a, vec b) { return _mm_cmplt_ps(a, b); }
+    static vec select(vec a, vec b, vec m) { return _mm_blendv_ps(a, b, m); }
+    template <int X>
+    static vec permute_xor(vec v) { return _mm_shuffle_ps(v, v, shuffle_xor<X>::value); }
+    template <int M>
+    static vec blend(vec a, vec b) { return _mm_blend_ps(a, b, M); }
+    static vec reverse(vec v) { return _mm_shuffle_ps(v, v, 0x1B); }
+    static value_type max_value() { return std::numeric_limits<value_type>::infinity(); }
+};
+
+}  // namespace
+
+namespace simdsort_detail {
+
+void sort_small_sse41(std::int32_t *data, std::size_t n) {
+    simdsort_kernels::sort_small<Sse41Int32>(data, n);
+}
+
+void sort_small_sse41(float *data, std::size_t n) {
+    simdsort_kernels::sort_small<Sse41Float>(data, n);
+}
+
+void merge_sse41(const std::int32_t *a, std::size_t na, const std::int32_t *b, std::size_t nb, std::int32_t *out) {
+    simdsort_kernels::merge<Sse41Int32>(a, na, b, nb, out);
+}
+
+void merge_sse41(const float *a, std::size_t na, const float *b, std::size_t nb, float *out) {
+    simdsort_kernels::merge<Sse41Float>(a, na, b, nb, out);
+}
+
+}  // namespace simdsort_detail
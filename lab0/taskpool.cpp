@@ -0,0 +1,113 @@
+#include "taskpool.hpp"
+
+namespace {
+
+// 当前线程所属的线程池及其队列下标；不属于任何线程池的线程使用 0 号队列
+thread_local const TaskPool *current_pool = nullptr;
+thread_local unsigned current_queue = 0;
+
+}  // namespace
+
+TaskPool::TaskPool(unsigned threads) : queued_(0), stop_(false) {
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.emplace_back(new Queue);
+    }
+    // 0 号队列属于调用 wait 的线程，其余每个队列对应一个工作线程
+    for (unsigned i = 1; i < threads; ++i) {
+        workers_.emplace_back(&TaskPool::worker_loop, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+unsigned TaskPool::current_index() const {
+    return current_pool == this ? current_queue : 0;
+}
+
+void TaskPool::run(TaskGroup &group, std::function<void()> task) {
+    group.pending_.fetch_add(1, std::memory_order_relaxed);
+    Queue &queue = *queues_[current_index()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{std::move(task), &group});
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+    // 加锁后再通知，避免工作线程检查完条件、还没睡下时错过通知
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+}
+
+bool TaskPool::run_one(unsigned self) {
+    Task task;
+    bool found = false;
+    {
+        Queue &own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    for (unsigned k = 1; !found && k < queues_.size(); ++k) {
+        Queue &victim = *queues_[(self + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    task.fn();
+    task.group->pending_.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void TaskPool::wait(TaskGroup &group) {
+    const TaskPool *saved_pool = current_pool;
+    unsigned saved_queue = current_queue;
+    unsigned self = current_index();
+    current_pool = this;
+    current_queue = self;
+    while (!group.done()) {
+        if (!run_one(self)) {
+            // 剩下的任务正在其它线程上执行
+            std::this_thread::yield();
+        }
+    }
+    current_pool = saved_pool;
+    current_queue = saved_queue;
+}
+
+void TaskPool::worker_loop(unsigned index) {
+    current_pool = this;
+    current_queue = index;
+    while (true) {
+        if (run_one(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_.load(std::memory_order_acquire) > 0; });
+        if (stop_) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef TASKPOOL_HPP
+#define TASKPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 一组任务，用于等待这组任务全部完成
+class TaskGroup {
+ public:
+    TaskGroup() : pending_(0) {}
+    bool done() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+ private:
+    friend class TaskPool;
+    std::atomic<std::size_t> pending_;
+};
+
+// 工作窃取线程池
+// 每个线程有自己的任务队列：自己从队尾取任务（后进先出，缓存友好），
+// 空闲时从其它线程的队头窃取任务（先进先出，窃取到的通常是较大的任务）
+// 调用 wait 的线程也参与执行任务，任务内部可以继续提交任务并等待
+class TaskPool {
+ public:
+    // threads 为参与计算的线程数（包括调用 wait 的线程），至少为 1
+    explicit TaskPool(unsigned threads);
+    ~TaskPool();
+
+    TaskPool(const TaskPool &) = delete;
+    TaskPool &operator=(const TaskPool &) = delete;
+
+    unsigned threads() const { return (unsigned)queues_.size(); }
+
+    // 提交属于 group 的任务，放入当前线程的队列
+    void run(TaskGroup &group, std::function<void()> task);
+    // 执行任务直到 group 中的任务全部完成
+    void wait(TaskGroup &group);
+
+ private:
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup *group;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void worker_loop(unsigned index);
+    // 取出一个任务执行，没有可执行的任务时返回 false
+    bool run_one(unsigned self);
+    unsigned current_index() const;
+
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> queued_;
+    std::atomic<bool> stop_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+};
+
+#endif
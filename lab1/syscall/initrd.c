@@ -1,10 +1,32 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <x86intrin.h>
+
+// 作为 init 运行的系统调用性能测试
+// 先演示 sys_hello，再对 sys_hello（不同缓冲区长度）、getpid、vDSO clock_gettime、
+// write /dev/null 分别计时：连续调用 ITERATIONS 次求平均周期数，再逐次计时求分位数
+// 最后检查批量版本 sys_hello_batch 的正确性，并与逐个调用 sys_hello 比较吞吐量
+// 编译：gcc -O2 -static -o init initrd.c
+
+#define SYS_HELLO 548
+#define SYS_HELLO_BATCH 549
+// 每项测试的调用次数（平均值和分位数各一轮）
+#define ITERATIONS 1000000
+#define WARMUP 10000
 
 void sys_hello(char *buf, int buf_len)
 {
-        long res = syscall(548, buf, buf_len);
+        long res = syscall(SYS_HELLO, buf, buf_len);
         if(res == -1)
         {
                 printf("Error! The lenth %d is too short\n", buf_len);
@@ -15,10 +37,355 @@ void sys_hello(char *buf, int buf_len)
         }
 }
 
+// sys_hello_batch 的描述符：内核向 buf 写入与 sys_hello 相同的内容，
+// status 为写入的字节数，长度不足时为 -EINVAL，buf 不可写时为 -EFAULT
+struct hello_iov {
+        char *buf;
+        size_t len;
+        long status;
+};
+
+// 一次 sys_hello_batch 最多处理的描述符个数，与内核一致
+#define HELLO_IOV_MAX 1024
+
+static long sys_hello_batch(struct hello_iov *vec, unsigned int cnt)
+{
+        return syscall(SYS_HELLO_BATCH, vec, cnt);
+}
+
+// lfence 保证 rdtsc 不会越过前后的指令提前或推后执行
+static inline uint64_t cycles(void)
+{
+        _mm_lfence();
+        uint64_t t = __rdtsc();
+        _mm_lfence();
+        return t;
+}
+
+struct bench {
+        const char *name;
+        long (*call)(struct bench *b);
+        char *buf;
+        int len;
+        int fd;
+};
+
+static long call_hello(struct bench *b)
+{
+        return syscall(SYS_HELLO, b->buf, b->len);
+}
+
+static long call_getpid(struct bench *b)
+{
+        (void)b;
+        // glibc 的 getpid 不缓存结果，这里直接用 syscall 保证每次都进入内核
+        return syscall(SYS_getpid);
+}
+
+static long call_clock_gettime(struct bench *b)
+{
+        (void)b;
+        struct timespec ts;
+        return clock_gettime(CLOCK_MONOTONIC, &ts);
+}
+
+static long call_write(struct bench *b)
+{
+        return write(b->fd, b->buf, b->len);
+}
+
+static uint64_t samples[ITERATIONS];
+// 两次 cycles() 之间没有任何代码时测得的周期数，逐次计时的结果减去该值
+static uint64_t timer_overhead;
+static double cycles_per_ns;
+
+static int cmp_u64(const void *a, const void *b)
+{
+        uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+        return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t n, double p)
+{
+        size_t i = (size_t)(p / 100.0 * (n - 1) + 0.5);
+        return sorted[i];
+}
+
+static void measure_timer_overhead(void)
+{
+        for (size_t i = 0; i < ITERATIONS / 10; ++i) {
+                uint64_t t0 = cycles();
+                samples[i] = cycles() - t0;
+        }
+        qsort(samples, ITERATIONS / 10, sizeof(samples[0]), cmp_u64);
+        timer_overhead = samples[ITERATIONS / 20];
+}
+
+// 用 CLOCK_MONOTONIC 标定 TSC 频率，用于把周期数换算为纳秒
+static void calibrate_tsc(void)
+{
+        struct timespec start, end, delay = {0, 100000000};
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t c0 = cycles();
+        nanosleep(&delay, NULL);
+        uint64_t c1 = cycles();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+        cycles_per_ns = (c1 - c0) / ns;
+}
+
+static void print_header(void)
+{
+        printf("%-24s %8s %10s %8s %8s %8s %8s %8s %10s\n", "call", "result", "mean", "min", "p50", "p90", "p99",
+               "p99.9", "mean(ns)");
+}
+
+static void run_bench(struct bench *b)
+{
+        errno = 0;
+        long res = b->call(b);
+        if (res == -1 && errno == ENOSYS) {
+                printf("%-24s %8s\n", b->name, "ENOSYS");
+                return;
+        }
+        char result[16];
+        if (res == -1) {
+                snprintf(result, sizeof(result), "%s", errno == EINVAL ? "EINVAL" : "error");
+        } else {
+                snprintf(result, sizeof(result), "%ld", res);
+        }
+
+        for (int i = 0; i < WARMUP; ++i) {
+                b->call(b);
+        }
+
+        // 连续调用求平均，不受逐次计时的开销影响
+        uint64_t t0 = cycles();
+        for (int i = 0; i < ITERATIONS; ++i) {
+                b->call(b);
+        }
+        double mean = (double)(cycles() - t0) / ITERATIONS;
+
+        for (int i = 0; i < ITERATIONS; ++i) {
+                uint64_t s = cycles();
+                b->call(b);
+                uint64_t d = cycles() - s;
+                samples[i] = d > timer_overhead ? d - timer_overhead : 0;
+        }
+        qsort(samples, ITERATIONS, sizeof(samples[0]), cmp_u64);
+
+        printf("%-24s %8s %10.1f %8llu %8llu %8llu %8llu %8llu %10.1f\n", b->name, result, mean,
+               (unsigned long long)samples[0], (unsigned long long)percentile(samples, ITERATIONS, 50),
+               (unsigned long long)percentile(samples, ITERATIONS, 90),
+               (unsigned long long)percentile(samples, ITERATIONS, 99),
+               (unsigned long long)percentile(samples, ITERATIONS, 99.9), mean / cycles_per_ns);
+}
+
+// 逐项比较批量调用与单次调用的结果：成功时内容相同，失败时缓冲区不被改动
+static void check_batch(void)
+{
+        static const size_t lens[] = {0, 1, 8, 16, 20, 50, 256};
+        enum { N = sizeof(lens) / sizeof(lens[0]) + 1 };
+        static char batch_buf[N][256], single_buf[256];
+        struct hello_iov vec[N];
+        int failures = 0;
+
+        printf("\nsys_hello_batch correctness\n");
+        for (size_t i = 0; i + 1 < N; ++i) {
+                memset(batch_buf[i], 0x5a, sizeof(batch_buf[i]));
+                vec[i].buf = batch_buf[i];
+                vec[i].len = lens[i];
+                vec[i].status = 1;
+        }
+        // 最后一项的缓冲区不可写，应当只影响这一项
+        vec[N - 1].buf = NULL;
+        vec[N - 1].len = 64;
+        vec[N - 1].status = 1;
+
+        errno = 0;
+        long done = sys_hello_batch(vec, N);
+        if (done == -1 && errno == ENOSYS) {
+                printf("syscall %d is not implemented by this kernel, skipped\n", SYS_HELLO_BATCH);
+                return;
+        }
+        if (done < 0) {
+                printf("FAIL: sys_hello_batch returned -1 (%s)\n", strerror(errno));
+                return;
+        }
+
+        long expected_done = 0;
+        for (size_t i = 0; i < N; ++i) {
+                long single = -1;
+                memset(single_buf, 0x5a, sizeof(single_buf));
+                if (vec[i].buf != NULL) {
+                        single = syscall(SYS_HELLO, single_buf, (int)vec[i].len);
+                }
+
+                int ok;
+                if (single == -1) {
+                        // 失败的项：状态为负的错误码，缓冲区保持原样
+                        // sys_hello 自己返回的错误码各人实现不同，这里不要求二者一致
+                        int untouched = 1;
+                        for (size_t k = 0; vec[i].buf && k < sizeof(batch_buf[i]); ++k) {
+                                untouched &= batch_buf[i][k] == 0x5a;
+                        }
+                        ok = vec[i].status < 0 && untouched;
+                } else {
+                        // 成功的项：与单次调用写入的内容相同，超出状态长度的部分不被改动
+                        ++expected_done;
+                        size_t n = vec[i].status > 0 ? (size_t)vec[i].status : 0;
+                        ok = n > 0 && n <= vec[i].len && memcmp(batch_buf[i], single_buf, sizeof(single_buf)) == 0 &&
+                             (n == sizeof(batch_buf[i]) || batch_buf[i][n] == 0x5a);
+                }
+                failures += !ok;
+                printf("  %-4s buf=%-5s len=%-4zu status=%ld\n", ok ? "ok" : "FAIL", vec[i].buf ? "valid" : "NULL",
+                       vec[i].len, vec[i].status);
+        }
+        if (done != expected_done) {
+                printf("FAIL: returned %ld, expected %ld successful entries\n", done, expected_done);
+                ++failures;
+        }
+
+        // 描述符个数超过上限时整个调用失败
+        // 传入真有 HELLO_IOV_MAX + 1 项、缓冲区都有效的数组：不检查上限的内核会全部处理并返回，
+        // 而不是越界读写 vec 所在的栈，把测试自己改坏
+        static char over_buf[HELLO_IOV_MAX + 1][64];
+        static struct hello_iov over_vec[HELLO_IOV_MAX + 1];
+        for (size_t i = 0; i < HELLO_IOV_MAX + 1; ++i) {
+                over_vec[i].buf = over_buf[i];
+                over_vec[i].len = sizeof(over_buf[i]);
+                over_vec[i].status = 0;
+        }
+        errno = 0;
+        if (sys_hello_batch(over_vec, HELLO_IOV_MAX + 1) != -1 || errno != EINVAL) {
+                printf("FAIL: more than %d descriptors should return EINVAL\n", HELLO_IOV_MAX);
+                ++failures;
+        }
+        printf("%s\n", failures ? "sys_hello_batch: FAILED" : "sys_hello_batch: all checks passed");
+}
+
+// 填充相同数量的缓冲区：每次批量处理 n 个描述符，对比逐个调用 sys_hello
+static void bench_batch(void)
+{
+        static const unsigned int sizes[] = {1, 4, 16, 64, 256};
+        static char bufs[256][64];
+        static struct hello_iov vec[256];
+
+        errno = 0;
+        vec[0].buf = bufs[0];
+        vec[0].len = sizeof(bufs[0]);
+        if (sys_hello_batch(vec, 1) == -1 && errno == ENOSYS) {
+                return;
+        }
+        errno = 0;
+        if (syscall(SYS_HELLO, bufs[0], (int)sizeof(bufs[0])) == -1 && errno == ENOSYS) {
+                return;
+        }
+
+        printf("\nfilling %d buffers of %zu bytes, TSC cycles per buffer\n", ITERATIONS, sizeof(bufs[0]));
+        printf("%8s %12s %12s %10s\n", "batch", "single", "batched", "speedup");
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+                unsigned int n = sizes[s];
+                for (unsigned int i = 0; i < n; ++i) {
+                        vec[i].buf = bufs[i];
+                        vec[i].len = sizeof(bufs[i]);
+                }
+                unsigned int calls = ITERATIONS / n;
+
+                // 计时循环不检查返回值，先确认这个批量大小下每个描述符都填写成功，否则这一行没有意义
+                for (unsigned int i = 0; i < n; ++i) {
+                        vec[i].status = 0;
+                }
+                long done = sys_hello_batch(vec, n);
+                unsigned int bad = 0;
+                for (unsigned int i = 0; i < n; ++i) {
+                        if (vec[i].status <= 0) {
+                                ++bad;
+                        }
+                }
+                if (done != (long)n || bad != 0) {
+                        printf("%8u   skipped: returned %ld, %u of %u descriptors failed\n", n, done, bad, n);
+                        continue;
+                }
+
+                uint64_t t0 = cycles();
+                for (unsigned int c = 0; c < calls; ++c) {
+                        for (unsigned int i = 0; i < n; ++i) {
+                                syscall(SYS_HELLO, bufs[i], (int)sizeof(bufs[i]));
+                        }
+                }
+                double single = (double)(cycles() - t0) / ((double)calls * n);
+
+                t0 = cycles();
+                for (unsigned int c = 0; c < calls; ++c) {
+                        sys_hello_batch(vec, n);
+                }
+                double batched = (double)(cycles() - t0) / ((double)calls * n);
+
+                printf("%8u %12.1f %12.1f %9.2fx\n", n, single, batched, single / batched);
+        }
+}
+
+// 内存盘中可能没有 /dev/null，需要时自己创建
+static int open_dev_null(void)
+{
+        int fd = open("/dev/null", O_WRONLY);
+        if (fd < 0 && errno == ENOENT) {
+                mkdir("/dev", 0755);
+                if (mknod("/dev/null", S_IFCHR | 0666, makedev(1, 3)) == 0) {
+                        fd = open("/dev/null", O_WRONLY);
+                }
+        }
+        if (fd < 0) {
+                perror("open /dev/null");
+        }
+        return fd;
+}
+
 int main() {
     //printf("Hello! PB22081571\n"); // Your Student ID
     char buf20[20], buf50[50];
     sys_hello(buf20,20);
     sys_hello(buf50,50);
-    while(1) {}
-}
\ No newline at end of file
+
+    static char buf[4096];
+    static const int hello_lens[] = {16, 20, 50, 256, 4096};
+    char names[sizeof(hello_lens) / sizeof(hello_lens[0])][32];
+
+    measure_timer_overhead();
+    calibrate_tsc();
+    printf("\nsyscall latency in TSC cycles (%d calls each, timer overhead %llu cycles, %.2f cycles/ns)\n",
+           ITERATIONS, (unsigned long long)timer_overhead, cycles_per_ns);
+    print_header();
+
+    for (size_t i = 0; i < sizeof(hello_lens) / sizeof(hello_lens[0]); ++i) {
+        snprintf(names[i], sizeof(names[i]), "hello(len=%d)", hello_lens[i]);
+        struct bench b = {names[i], call_hello, buf, hello_lens[i], -1};
+        run_bench(&b);
+    }
+
+    struct bench getpid_bench = {"getpid", call_getpid, NULL, 0, -1};
+    run_bench(&getpid_bench);
+
+    struct bench clock_bench = {"clock_gettime (vDSO)", call_clock_gettime, NULL, 0, -1};
+    run_bench(&clock_bench);
+
+    int null_fd = open_dev_null();
+    if (null_fd >= 0) {
+        struct bench write_bench = {"write(/dev/null, 1)", call_write, buf, 1, null_fd};
+        run_bench(&write_bench);
+        close(null_fd);
+    }
+
+    check_batch();
+    bench_batch();
+    fflush(stdout);
+
+    // init 退出会导致 kernel panic，测试结束后睡眠等待信号而不是空转占满 CPU
+    if (getpid() == 1) {
+        while (1) {
+            pause();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,677 @@
+#include "lineeditor.hpp"
+
+// IO
+#include <iostream>
+// std::ifstream
+#include <fstream>
+// std::sort, std::lower_bound
+#include <algorithm>
+// getenv
+#include <cstdlib>
+// POSIX API
+#include <unistd.h>
+// errno
+#include <errno.h>
+// open
+#include <fcntl.h>
+// opendir, readdir
+#include <dirent.h>
+// stat
+#include <sys/stat.h>
+// ioctl, TIOCGWINSZ
+#include <sys/ioctl.h>
+
+namespace {
+
+// 历史记录最多保留的条数
+const size_t MAX_HISTORY = 100000;
+
+// 按键
+const char KEY_CTRL_A = 1;
+const char KEY_CTRL_B = 2;
+const char KEY_CTRL_C = 3;
+const char KEY_CTRL_D = 4;
+const char KEY_CTRL_E = 5;
+const char KEY_CTRL_F = 6;
+const char KEY_CTRL_G = 7;
+const char KEY_CTRL_H = 8;
+const char KEY_TAB = 9;
+const char KEY_CTRL_K = 11;
+const char KEY_CTRL_L = 12;
+const char KEY_ENTER = 13;
+const char KEY_CTRL_N = 14;
+const char KEY_CTRL_P = 16;
+const char KEY_CTRL_R = 18;
+const char KEY_CTRL_U = 21;
+const char KEY_CTRL_W = 23;
+const char KEY_ESC = 27;
+const char KEY_BACKSPACE = 127;
+
+bool starts_with(const std::string &s, const std::string &prefix) {
+  return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+// UTF-8 中的后续字节形如 10xxxxxx，光标移动时跳过
+bool is_continuation(char c) {
+  return (c & 0xC0) == 0x80;
+}
+
+// 按字符（而不是字节）计算显示宽度
+size_t display_width(const std::string &s, size_t begin, size_t end) {
+  size_t width = 0;
+  for (size_t i = begin; i < end; ++i) {
+    if (!is_continuation(s[i])) {
+      width++;
+    }
+  }
+  return width;
+}
+
+size_t prev_char(const std::string &s, size_t pos) {
+  if (pos == 0) {
+    return 0;
+  }
+  do {
+    pos--;
+  } while (pos > 0 && is_continuation(s[pos]));
+  return pos;
+}
+
+size_t next_char(const std::string &s, size_t pos) {
+  if (pos >= s.size()) {
+    return s.size();
+  }
+  do {
+    pos++;
+  } while (pos < s.size() && is_continuation(s[pos]));
+  return pos;
+}
+
+// 从终端读一个字节，被信号中断时重试，EOF 或出错时返回 false
+bool read_byte(char &c) {
+  while (true) {
+    ssize_t n = read(STDIN_FILENO, &c, 1);
+    if (n == 1) {
+      return true;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    return false;
+  }
+}
+
+void write_str(const std::string &s) {
+  size_t written = 0;
+  while (written < s.size()) {
+    ssize_t n = write(STDOUT_FILENO, s.data() + written, s.size() - written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    written += n;
+  }
+}
+
+int terminal_columns() {
+  struct winsize ws;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1 || ws.ws_col == 0) {
+    return 80;
+  }
+  return ws.ws_col;
+}
+
+// 从 start 向前查找包含 query 的历史记录，找不到时返回 npos
+size_t search_history(const std::vector<std::string> &history, const std::string &query, size_t start) {
+  if (history.empty()) {
+    return std::string::npos;
+  }
+  for (size_t i = std::min(start, history.size() - 1) + 1; i-- > 0;) {
+    if (history[i].find(query) != std::string::npos) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+}  // namespace
+
+void CommandIndex::set_builtins(const std::vector<std::string> &names) {
+  builtins_ = names;
+  dirty_ = true;
+}
+
+std::vector<std::string> CommandIndex::complete(const std::string &prefix) {
+  refresh();
+  std::vector<std::string> res;
+  for (auto it = std::lower_bound(merged_.begin(), merged_.end(), prefix);
+       it != merged_.end() && starts_with(*it, prefix); ++it) {
+    res.push_back(*it);
+  }
+  return res;
+}
+
+void CommandIndex::refresh() {
+  const char *env = getenv("PATH");
+  std::string path_env = env ? env : "";
+
+  // $PATH 变化时重建目录列表，仍在 $PATH 中的目录保留已有的扫描结果
+  if (path_env != path_env_) {
+    path_env_ = path_env;
+    std::vector<Directory> dirs;
+    size_t begin = 0;
+    while (begin <= path_env.size()) {
+      size_t end = path_env.find(':', begin);
+      if (end == std::string::npos) {
+        end = path_env.size();
+      }
+      std::string path = path_env.substr(begin, end - begin);
+      begin = end + 1;
+      if (path.empty()) {
+        continue;
+      }
+      Directory dir;
+      dir.path = path;
+      for (auto &old : dirs_) {
+        if (old.path == path) {
+          dir = old;
+          break;
+        }
+      }
+      dirs.push_back(dir);
+    }
+    dirs_.swap(dirs);
+    dirty_ = true;
+  }
+
+  // 每个目录只做一次 stat，mtime 不变就跳过
+  for (auto &dir : dirs_) {
+    struct stat st;
+    if (stat(dir.path.c_str(), &st) == -1) {
+      if (dir.scanned) {
+        dir.scanned = false;
+        dir.names.clear();
+        dirty_ = true;
+      }
+      continue;
+    }
+    if (dir.scanned && dir.mtime.tv_sec == st.st_mtim.tv_sec && dir.mtime.tv_nsec == st.st_mtim.tv_nsec) {
+      continue;
+    }
+    dir.mtime = st.st_mtim;
+    dir.scanned = true;
+    scan(dir);
+    dirty_ = true;
+  }
+
+  if (dirty_) {
+    merged_ = builtins_;
+    for (auto &dir : dirs_) {
+      merged_.insert(merged_.end(), dir.names.begin(), dir.names.end());
+    }
+    std::sort(merged_.begin(), merged_.end());
+    merged_.erase(std::unique(merged_.begin(), merged_.end()), merged_.end());
+    dirty_ = false;
+  }
+}
+
+// 收集目录中可执行的普通文件
+void CommandIndex::scan(Directory &dir) {
+  dir.names.clear();
+  DIR *d = opendir(dir.path.c_str());
+  if (!d) {
+    return;
+  }
+  int dfd = dirfd(d);
+  struct dirent *entry;
+  while ((entry = readdir(d)) != nullptr) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    struct stat st;
+    if (fstatat(dfd, entry->d_name, &st, 0) == -1 || !S_ISREG(st.st_mode)) {
+      continue;
+    }
+    if (faccessat(dfd, entry->d_name, X_OK, 0) == 0) {
+      dir.names.push_back(entry->d_name);
+    }
+  }
+  closedir(d);
+}
+
+LineEditor::LineEditor(const std::string &history_path)
+    : history_path_(history_path), is_tty_(isatty(STDIN_FILENO) && isatty(STDOUT_FILENO)) {
+  load_history();
+}
+
+// 读入历史文件，超过上限时只保留最近的记录并重写文件
+void LineEditor::load_history() {
+  if (history_path_.empty()) {
+    return;
+  }
+  std::ifstream in(history_path_);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty()) {
+      history_.push_back(line);
+    }
+  }
+  if (history_.size() > MAX_HISTORY) {
+    history_.erase(history_.begin(), history_.end() - MAX_HISTORY);
+    std::ofstream out(history_path_, std::ios::trunc);
+    for (auto &entry : history_) {
+      out << entry << "\n";
+    }
+  }
+}
+
+void LineEditor::add_history(const std::string &line) {
+  if (line.empty() || (!history_.empty() && history_.back() == line)) {
+    return;
+  }
+  history_.push_back(line);
+  // 超过上限后成批删除最早的记录，避免每次都移动整个数组
+  if (history_.size() > MAX_HISTORY + MAX_HISTORY / 10) {
+    history_.erase(history_.begin(), history_.end() - MAX_HISTORY);
+  }
+  if (history_path_.empty()) {
+    return;
+  }
+  int fd = open(history_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0600);
+  if (fd < 0) {
+    return;
+  }
+  std::string entry = line + "\n";
+  if (write(fd, entry.data(), entry.size()) < 0) {
+    perror("write history failed");
+  }
+  close(fd);
+}
+
+bool LineEditor::read_line(const std::string &prompt, std::string &line) {
+  if (!is_tty_) {
+    std::cout << prompt;
+    return static_cast<bool>(std::getline(std::cin, line));
+  }
+  std::cout.flush();
+  if (!enable_raw_mode()) {
+    std::cout << prompt;
+    return static_cast<bool>(std::getline(std::cin, line));
+  }
+  prompt_ = prompt;
+  bool ok = edit_line(line);
+  disable_raw_mode();
+  return ok;
+}
+
+bool LineEditor::enable_raw_mode() {
+  if (tcgetattr(STDIN_FILENO, &orig_termios_) == -1) {
+    return false;
+  }
+  struct termios raw = orig_termios_;
+  // 关闭回显、行缓冲和信号键，Ctrl-C 等按键由编辑器自己处理；保留输出处理，"\n" 仍输出为换行
+  raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+  raw.c_cflag |= CS8;
+  raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+  raw.c_cc[VMIN] = 1;
+  raw.c_cc[VTIME] = 0;
+  return tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == 0;
+}
+
+void LineEditor::disable_raw_mode() {
+  tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_termios_);
+}
+
+void LineEditor::refresh_line() {
+  size_t cols = terminal_columns();
+  size_t prompt_width = display_width(prompt_, 0, prompt_.size());
+  if (prompt_width + 1 >= cols) {
+    cols = prompt_width + 2;
+  }
+  size_t avail = cols - prompt_width - 1;
+
+  // 光标前的内容放不下时从左侧截断
+  size_t start = 0;
+  size_t before = display_width(buf_, 0, pos_);
+  while (before > avail) {
+    start = next_char(buf_, start);
+    before--;
+  }
+  // 光标后的内容放不下时从右侧截断
+  size_t end = pos_, width = before;
+  while (end < buf_.size() && width < avail) {
+    end = next_char(buf_, end);
+    width++;
+  }
+
+  std::string out = "\r" + prompt_ + buf_.substr(start, end - start) + "\x1b[K\r";
+  size_t col = prompt_width + before;
+  if (col > 0) {
+    out += "\x1b[" + std::to_string(col) + "C";
+  }
+  write_str(out);
+}
+
+bool LineEditor::edit_line(std::string &line) {
+  buf_.clear();
+  pos_ = 0;
+  history_index_ = history_.size();
+  saved_line_.clear();
+  last_was_tab_ = false;
+  refresh_line();
+
+  char pending = 0;
+  while (true) {
+    char c;
+    if (pending) {
+      c = pending;
+      pending = 0;
+    } else if (!read_byte(c)) {
+      write_str("\n");
+      if (buf_.empty()) {
+        return false;
+      }
+      line = buf_;
+      return true;
+    }
+
+    bool is_tab = c == KEY_TAB;
+    switch (c) {
+      case KEY_ENTER:
+      case '\n':
+        write_str("\n");
+        line = buf_;
+        return true;
+      case KEY_CTRL_C:
+        // 丢弃当前输入，在新的一行重新输出提示符
+        write_str("^C\n");
+        buf_.clear();
+        pos_ = 0;
+        history_index_ = history_.size();
+        break;
+      case KEY_CTRL_D:
+        if (buf_.empty()) {
+          return false;
+        }
+        if (pos_ < buf_.size()) {
+          buf_.erase(pos_, next_char(buf_, pos_) - pos_);
+        }
+        break;
+      case KEY_BACKSPACE:
+      case KEY_CTRL_H:
+        if (pos_ > 0) {
+          size_t prev = prev_char(buf_, pos_);
+          buf_.erase(prev, pos_ - prev);
+          pos_ = prev;
+        }
+        break;
+      case KEY_CTRL_A:
+        pos_ = 0;
+        break;
+      case KEY_CTRL_E:
+        pos_ = buf_.size();
+        break;
+      case KEY_CTRL_B:
+        pos_ = prev_char(buf_, pos_);
+        break;
+      case KEY_CTRL_F:
+        pos_ = next_char(buf_, pos_);
+        break;
+      case KEY_CTRL_K:
+        buf_.erase(pos_);
+        break;
+      case KEY_CTRL_U:
+        buf_.erase(0, pos_);
+        pos_ = 0;
+        break;
+      case KEY_CTRL_W: {
+        size_t start = pos_;
+        while (start > 0 && buf_[start - 1] == ' ') start--;
+        while (start > 0 && buf_[start - 1] != ' ') start--;
+        buf_.erase(start, pos_ - start);
+        pos_ = start;
+        break;
+      }
+      case KEY_CTRL_L:
+        write_str("\x1b[H\x1b[2J");
+        break;
+      case KEY_CTRL_P:
+        history_move(-1);
+        break;
+      case KEY_CTRL_N:
+        history_move(1);
+        break;
+      case KEY_CTRL_R:
+        pending = reverse_search();
+        break;
+      case KEY_TAB:
+        complete();
+        break;
+      case KEY_ESC: {
+        // 方向键等转义序列：ESC [ X、ESC [ n ~ 或 ESC O X
+        char seq[3];
+        if (!read_byte(seq[0]) || !read_byte(seq[1])) {
+          break;
+        }
+        if (seq[0] == '[' && seq[1] >= '0' && seq[1] <= '9') {
+          if (!read_byte(seq[2]) || seq[2] != '~') {
+            break;
+          }
+          if (seq[1] == '1' || seq[1] == '7') {
+            pos_ = 0;
+          } else if (seq[1] == '4' || seq[1] == '8') {
+            pos_ = buf_.size();
+          } else if (seq[1] == '3' && pos_ < buf_.size()) {
+            buf_.erase(pos_, next_char(buf_, pos_) - pos_);
+          }
+        } else if (seq[0] == '[' || seq[0] == 'O') {
+          switch (seq[1]) {
+            case 'A': history_move(-1); break;
+            case 'B': history_move(1); break;
+            case 'C': pos_ = next_char(buf_, pos_); break;
+            case 'D': pos_ = prev_char(buf_, pos_); break;
+            case 'H': pos_ = 0; break;
+            case 'F': pos_ = buf_.size(); break;
+          }
+        }
+        break;
+      }
+      default:
+        // 其余控制字符忽略，可见字符插入到光标处
+        if ((unsigned char)c >= 32) {
+          buf_.insert(pos_, 1, c);
+          pos_++;
+        }
+        break;
+    }
+    last_was_tab_ = is_tab;
+    refresh_line();
+  }
+}
+
+// 上下浏览历史记录，离开正在编辑的新行时先保存其内容
+void LineEditor::history_move(int delta) {
+  if (delta < 0 && history_index_ == 0) {
+    return;
+  }
+  if (delta > 0 && history_index_ >= history_.size()) {
+    return;
+  }
+  if (history_index_ == history_.size()) {
+    saved_line_ = buf_;
+  }
+  history_index_ += delta;
+  buf_ = history_index_ == history_.size() ? saved_line_ : history_[history_index_];
+  pos_ = buf_.size();
+}
+
+// 增量搜索：每输入一个字符，从当前匹配处继续向前查找包含搜索串的历史记录
+// 再按 Ctrl-R 查找更早的匹配，Ctrl-G 放弃搜索恢复原来的内容
+// 回车或其它编辑键接受当前匹配，并把该按键交还给 edit_line 处理
+char LineEditor::reverse_search() {
+  std::string original = buf_;
+  size_t original_pos = pos_;
+  std::string query;
+  size_t match = std::string::npos;
+  bool failed = false;
+
+  while (true) {
+    std::string shown = match == std::string::npos ? "" : history_[match];
+    std::string prefix = failed ? "(failed reverse-i-search)`" : "(reverse-i-search)`";
+    write_str("\r" + prefix + query + "': " + shown + "\x1b[K");
+
+    char c;
+    if (!read_byte(c)) {
+      return KEY_CTRL_D;
+    }
+    if (c == KEY_CTRL_R) {
+      if (match != std::string::npos && match > 0) {
+        size_t found = search_history(history_, query, match - 1);
+        failed = found == std::string::npos;
+        if (!failed) {
+          match = found;
+        }
+      }
+    } else if (c == KEY_BACKSPACE || c == KEY_CTRL_H) {
+      query.erase(prev_char(query, query.size()));
+      match = query.empty() ? std::string::npos : search_history(history_, query, history_.size());
+      failed = !query.empty() && match == std::string::npos;
+    } else if (c == KEY_CTRL_G) {
+      buf_ = original;
+      pos_ = original_pos;
+      return 0;
+    } else if ((unsigned char)c >= 32) {
+      query += c;
+      size_t found = search_history(history_, query, match == std::string::npos ? history_.size() : match);
+      failed = found == std::string::npos;
+      if (!failed) {
+        match = found;
+      }
+    } else {
+      if (c == KEY_CTRL_C) {
+        buf_ = original;
+      } else if (match != std::string::npos) {
+        buf_ = history_[match];
+        history_index_ = match;
+      }
+      pos_ = buf_.size();
+      return c;
+    }
+  }
+}
+
+// 补全光标前的单词
+// 子命令的第一个单词且不含 "/" 时补全命令名，否则补全路径
+// 唯一候选时直接补全；多个候选时补全公共前缀，连续两次 Tab 时列出所有候选
+void LineEditor::complete() {
+  size_t start = pos_;
+  while (start > 0 && buf_[start - 1] != ' ' && buf_[start - 1] != '|') {
+    start--;
+  }
+  std::string word = buf_.substr(start, pos_ - start);
+
+  size_t before = start;
+  while (before > 0 && buf_[before - 1] == ' ') {
+    before--;
+  }
+  bool is_command = (before == 0 || buf_[before - 1] == '|') && word.find('/') == std::string::npos;
+
+  std::vector<std::string> candidates;
+  if (is_command) {
+    candidates = commands_.complete(word);
+  } else {
+    path_candidates(word, candidates);
+  }
+  if (candidates.empty()) {
+    write_str("\a");
+    return;
+  }
+
+  // 计算公共前缀
+  std::string common = candidates[0];
+  for (auto &candidate : candidates) {
+    size_t n = 0;
+    while (n < common.size() && n < candidate.size() && common[n] == candidate[n]) {
+      n++;
+    }
+    common.resize(n);
+  }
+
+  if (candidates.size() == 1) {
+    // 目录补全后继续输入路径，其余补全后加空格
+    if (common.empty() || common.back() != '/') {
+      common += ' ';
+    }
+  }
+  if (common.size() > word.size()) {
+    buf_.replace(start, pos_ - start, common);
+    pos_ = start + common.size();
+    return;
+  }
+
+  if (!last_was_tab_) {
+    write_str("\a");
+    return;
+  }
+
+  // 列出候选，路径只显示最后一段
+  const size_t MAX_SHOWN = 200;
+  size_t width = 0;
+  std::vector<std::string> names;
+  for (size_t i = 0; i < candidates.size() && i < MAX_SHOWN; ++i) {
+    std::string name = candidates[i];
+    size_t slash = name.find_last_of('/', name.size() >= 2 ? name.size() - 2 : 0);
+    if (!is_command && slash != std::string::npos) {
+      name = name.substr(slash + 1);
+    }
+    width = std::max(width, display_width(name, 0, name.size()) + 2);
+    names.push_back(name);
+  }
+  size_t per_line = std::max<size_t>(1, terminal_columns() / width);
+  std::string out = "\n";
+  for (size_t i = 0; i < names.size(); ++i) {
+    out += names[i];
+    if ((i + 1) % per_line == 0 || i + 1 == names.size()) {
+      out += "\n";
+    } else {
+      out += std::string(width - display_width(names[i], 0, names[i].size()), ' ');
+    }
+  }
+  if (candidates.size() > MAX_SHOWN) {
+    out += "... and " + std::to_string(candidates.size() - MAX_SHOWN) + " more\n";
+  }
+  write_str(out);
+}
+
+// 列出与 word 匹配的路径，目录以 "/" 结尾
+void LineEditor::path_candidates(const std::string &word, std::vector<std::string> &out) {
+  size_t slash = word.find_last_of('/');
+  std::string dir = slash == std::string::npos ? "" : word.substr(0, slash + 1);
+  std::string base = slash == std::string::npos ? word : word.substr(slash + 1);
+
+  DIR *d = opendir(dir.empty() ? "." : dir.c_str());
+  if (!d) {
+    return;
+  }
+  struct dirent *entry;
+  while ((entry = readdir(d)) != nullptr) {
+    std::string name = entry->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    // 以 "." 开头的文件只有在输入了 "." 时才补全
+    if (!starts_with(name, base) || (name[0] == '.' && base.empty())) {
+      continue;
+    }
+    std::string path = dir + name;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      path += '/';
+    }
+    out.push_back(path);
+  }
+  closedir(d);
+  std::sort(out.begin(), out.end());
+}
@@ -0,0 +1,88 @@
+#ifndef LINEEDITOR_HPP
+#define LINEEDITOR_HPP
+
+// std::string
+#include <string>
+// std::vector
+#include <vector>
+// struct termios
+#include <termios.h>
+// struct timespec
+#include <time.h>
+
+// $PATH 中可执行文件的索引，用于命令补全
+// 每个目录记录上次扫描时的 mtime，只有目录内容变化时才重新扫描该目录
+// 所有名字合并为一个有序数组，前缀查找用二分完成
+class CommandIndex {
+ public:
+  // 设置额外参与补全的名字（内建命令）
+  void set_builtins(const std::vector<std::string> &names);
+  // 返回以 prefix 开头的所有命令名，已排序去重
+  std::vector<std::string> complete(const std::string &prefix);
+
+ private:
+  struct Directory {
+    std::string path;
+    bool scanned = false;
+    struct timespec mtime;
+    std::vector<std::string> names;
+  };
+
+  // 检查 $PATH 和各目录的 mtime，按需重新扫描并重建合并后的数组
+  void refresh();
+  void scan(Directory &dir);
+
+  std::string path_env_;
+  std::vector<Directory> dirs_;
+  std::vector<std::string> builtins_;
+  std::vector<std::string> merged_;
+  bool dirty_ = true;
+};
+
+// 行编辑器：终端 raw 模式下支持光标移动、历史记录、Ctrl-R 增量搜索和 Tab 补全
+// 标准输入不是终端时退化为逐行读入
+class LineEditor {
+ public:
+  // history_path 为空时不保存历史记录
+  explicit LineEditor(const std::string &history_path);
+
+  // 打印提示符并读入一行（不含换行符），EOF 时返回 false
+  bool read_line(const std::string &prompt, std::string &line);
+  // 把一行命令加入历史记录并追加到历史文件
+  void add_history(const std::string &line);
+
+  CommandIndex &commands() { return commands_; }
+
+ private:
+  bool enable_raw_mode();
+  void disable_raw_mode();
+  // 在终端中读入并编辑一行，EOF 时返回 false
+  bool edit_line(std::string &line);
+  // 重新绘制提示符和当前行，行过长时水平滚动保证光标可见
+  void refresh_line();
+  void history_move(int delta);
+  // Ctrl-R 增量搜索，返回退出搜索的按键，交给 edit_line 继续处理；0 表示没有需要处理的按键
+  char reverse_search();
+  void complete();
+  void path_candidates(const std::string &word, std::vector<std::string> &out);
+  void load_history();
+
+  std::string history_path_;
+  std::vector<std::string> history_;
+  CommandIndex commands_;
+  bool is_tty_;
+  struct termios orig_termios_;
+
+  // 当前编辑状态
+  std::string prompt_;
+  std::string buf_;
+  size_t pos_ = 0;
+  // 正在浏览的历史记录下标，等于 history_.size() 时表示正在编辑的新行
+  size_t history_index_ = 0;
+  // 开始浏览历史记录前正在编辑的内容
+  std::string saved_line_;
+  // 上一个按键是否为 Tab，连续两次 Tab 时列出所有候选
+  bool last_was_tab_ = false;
+};
+
+#endif
@@ -8,6 +8,8 @@
 #include <sstream>
 // PATH_MAX 等常量
 #include <climits>
+// strlen
+#include <cstring>
 // POSIX API
 #include <unistd.h>
 // wait
@@ -20,9 +22,190 @@
 #include <signal.h>
 // getpnam
 #include <pwd.h>
+// memfd_create
+#include <sys/mman.h>
+// wait4, getrusage
+#include <sys/resource.h>
+// timersub
+#include <sys/time.h>
+// clock_gettime
+#include <time.h>
+// 格式化输出耗时
+#include <iomanip>
+// poll
+#include <poll.h>
+// signalfd
+#include <sys/signalfd.h>
+// 行编辑器
+#include "lineeditor.hpp"
+
+// Shell 的运行状态，内建命令通过它读写后台进程列表和工作目录
+struct ShellState {
+  // 用来储存后台进程的PID
+  std::vector<pid_t> bg_pids;
+  // 用来储存上一次的工作目录
+  std::string oldwd;
+  // exit 命令请求退出 Shell
+  bool should_exit = false;
+  // Shell 退出时的返回值
+  int exit_code = 0;
+  // 是否为管道创建进程组并切换终端前台，进程替换中的子 Shell 不做作业控制
+  bool job_control = true;
+  // 是否为每个前台命令输出资源统计，由 timing 命令开关
+  bool report_jobs = false;
+};
+
+// 重定向类型
+enum RedirectType {
+  REDIRECT_IN,          // <
+  REDIRECT_OUT,         // >
+  REDIRECT_APPEND,      // >>
+  REDIRECT_HEREDOC,     // <<
+  REDIRECT_HERESTRING,  // <<<
+};
+
+struct Redirect {
+  RedirectType type;
+  // 文件名、here-doc 的结束标记或 here-string 的内容
+  std::string target;
+  // target 是否含有引号，带引号的 "<(...)" 只是文件名，不做进程替换
+  bool quoted = false;
+  // here-doc 的内容，由主循环在读完命令行后继续读入
+  std::string body;
+};
+
+// 管道中的一个子命令
+struct Stage {
+  std::vector<std::string> args;
+  // quoted[i] 表示 args[i] 是否含有引号，带引号的参数不做进程替换
+  std::vector<bool> quoted;
+  std::vector<Redirect> redirects;
+};
+
+// parallel 命令中正在运行的一个任务
+struct ParallelJob {
+  pid_t pid;
+  // 子进程是否已回收，以及回收时的退出状态；已回收的任务不再占用并行名额
+  bool exited;
+  int status;
+  // 任务编号（从 1 开始）和对应的输入
+  size_t index;
+  std::string input;
+  // 子进程标准输出和标准错误的管道读端，读到 EOF 后置为 -1
+  int out_fd, err_fd;
+  // 子进程退出且管道读完之前缓存的全部输出，之后一次写出，避免不同任务的输出交错
+  std::string out, err;
+};
+
+// 一个子命令的资源统计
+struct StageReport {
+  std::string name;
+  // 创建和回收子进程的时刻
+  struct timespec start, end;
+  struct rusage usage;
+  // 是否是在 Shell 进程内执行的内建命令
+  bool builtin = false;
+};
+
+// 内建命令编号，0 表示不是内建命令
+enum BuiltinId {
+  BUILTIN_NONE = 0,
+  BUILTIN_EXIT,
+  BUILTIN_PWD,
+  BUILTIN_CD,
+  BUILTIN_WAIT,
+  BUILTIN_ECHO,
+  BUILTIN_TIMING,
+  BUILTIN_PARALLEL,
+  // 内建命令个数加一，用于检查内建命令表是否完整
+  BUILTIN_COUNT,
+};
+
+// 内建命令的统一接口：返回值即命令的退出码
+typedef int (*BuiltinFunc)(const std::vector<std::string> &args, ShellState &state);
 
 std::vector<std::string> split(std::string s, const std::string &delimiter);
-void sigint_handler(int sig); 
+void sigint_handler(int sig);
+BuiltinId find_builtin(const std::string &name);
+bool split_pipeline(const std::string &cmd, std::vector<std::string> &scomds);
+bool tokenize(const std::string &s, std::vector<std::string> &words, std::vector<bool> &quoted);
+bool parse_pipeline(const std::string &cmd, std::vector<Stage> &stages);
+bool is_process_substitution(const std::string &word);
+bool has_process_substitution(const Stage &stage);
+bool expand_process_substitutions(std::vector<std::string> &args, const std::vector<bool> &quoted,
+                                  ShellState &state);
+int open_data_fd(const std::string &data);
+bool apply_redirections(Stage &stage);
+int run_builtin(BuiltinId id, std::vector<std::string> &args, ShellState &state);
+void run_command_line(const std::string &cmd, ShellState &state);
+void run_pipeline(std::vector<Stage> &stages, bool bg_command, bool timed, ShellState &state);
+bool strip_time_keyword(std::string &cmd);
+void print_job_report(const std::vector<StageReport> &reports);
+std::string get_cwd();
+bool write_all(int fd, const std::string &data);
+bool spawn_parallel_job(const std::vector<std::string> &cmd, ParallelJob &job, ShellState &state);
+
+int builtin_exit(const std::vector<std::string> &args, ShellState &state);
+int builtin_pwd(const std::vector<std::string> &args, ShellState &state);
+int builtin_cd(const std::vector<std::string> &args, ShellState &state);
+int builtin_wait(const std::vector<std::string> &args, ShellState &state);
+int builtin_echo(const std::vector<std::string> &args, ShellState &state);
+int builtin_timing(const std::vector<std::string> &args, ShellState &state);
+int builtin_parallel(const std::vector<std::string> &args, ShellState &state);
+
+// 内建命令表：按名字查找、按编号分派和命令补全都以这张表为准，新增内建命令只需在这里加一行
+// 第 i 项的编号必须是 i + 1，run_builtin 直接按编号下标访问
+struct BuiltinEntry {
+  const char *name;
+  BuiltinId id;
+  BuiltinFunc func;
+};
+
+constexpr BuiltinEntry builtin_table[] = {
+  {"exit", BUILTIN_EXIT, builtin_exit},
+  {"pwd", BUILTIN_PWD, builtin_pwd},
+  {"cd", BUILTIN_CD, builtin_cd},
+  {"wait", BUILTIN_WAIT, builtin_wait},
+  {"echo", BUILTIN_ECHO, builtin_echo},
+  {"timing", BUILTIN_TIMING, builtin_timing},
+  {"parallel", BUILTIN_PARALLEL, builtin_parallel},
+};
+const size_t builtin_count = sizeof(builtin_table) / sizeof(builtin_table[0]);
+static_assert(builtin_count == BUILTIN_COUNT - 1, "every BuiltinId needs an entry in builtin_table");
+
+constexpr bool builtin_table_in_order(size_t i = 0) {
+  return i == builtin_count || (builtin_table[i].id == BuiltinId(i + 1) && builtin_table_in_order(i + 1));
+}
+static_assert(builtin_table_in_order(), "builtin_table must be ordered by BuiltinId");
+
+// 由内建命令表生成的散列表，find_builtin 用它按名字查找
+// 散列值只取名字的长度、首字母和末字母，槽数是命令数的数倍，冲突时线性探测
+const size_t builtin_slots = 32;
+static_assert(builtin_count < builtin_slots, "builtin hash table is too small");
+
+inline size_t builtin_hash(const char *name, size_t length) {
+  return (length * 7 + (unsigned char)name[0] * 3 + (unsigned char)name[length - 1]) % builtin_slots;
+}
+
+struct BuiltinIndex {
+  // 空槽为 BUILTIN_NONE
+  BuiltinId slots[builtin_slots];
+
+  BuiltinIndex() {
+    for (auto &slot : slots) {
+      slot = BUILTIN_NONE;
+    }
+    for (auto &entry : builtin_table) {
+      size_t h = builtin_hash(entry.name, strlen(entry.name));
+      while (slots[h] != BUILTIN_NONE) {
+        h = (h + 1) % builtin_slots;
+      }
+      slots[h] = entry.id;
+    }
+  }
+};
+
+const BuiltinIndex builtin_index;
 
 int main() {
   // 不同步 iostream 和 cstdio 的 buffer
@@ -31,14 +214,8 @@ int main() {
   // 用来存储读入的一行命令
   std::string cmd;
 
-  // 用来储存后台进程的PID
-  std::vector<pid_t> bg_pids;
-
-  // 用来储存上一次的工作目录
-  std::string oldwd;
-
-  // 用来储存父进程(Shell)的PID
-  pid_t ppid = getpid();
+  // Shell 的运行状态
+  ShellState state;
 
   // 用来表示命令是否在后台执行
   bool bg_command;
@@ -49,200 +226,201 @@ int main() {
   // 对于SIGTTOU信号，直接忽略
   signal(SIGTTOU, SIG_IGN);
 
+  // 行编辑器，历史记录保存在家目录下的 .shell_history
+  const char *home = getenv("HOME");
+  LineEditor editor(home ? std::string(home) + "/.shell_history" : "");
+  std::vector<std::string> builtin_names;
+  for (auto &entry : builtin_table) {
+    builtin_names.push_back(entry.name);
+  }
+  editor.commands().set_builtins(builtin_names);
+
   while (true) {
+    // 打印提示符并读入一行，结果不包含换行符
     // 如果输入按下Ctr+D（识别为EOF）,退出shell程序
-    if(std::cin.eof()) {
+    if (!editor.read_line("$ ", cmd)) {
       std::cout << "^D\n";
       return 0;
     }
-    // 打印提示符
-    std::cout << "$ ";
+    editor.add_history(cmd);
 
-    // 读入一行。std::getline 结果不包含换行符。
-    std::getline(std::cin, cmd);
-
-    if (cmd.back() == '&') {
+    if (!cmd.empty() && cmd.back() == '&') {
       // 如果命令以&结尾，去掉&，并将命令放入后台执行
-      cmd.pop_back(); 
+      cmd.pop_back();
       bg_command = true;
     } else {
       bg_command = false;
     }
-    
-    // 按空格分割命令为单词
-    std::vector<std::string> args = split(cmd, " ");
 
-    // 按" | "分割命令为子命令
-    std::vector<std::string> scomds = split(cmd, " | ");
+    // 以 time 开头的命令在结束后输出各子命令的资源统计
+    bool timed = strip_time_keyword(cmd);
 
-    // 为创建管道而设置的数组
-    int fd[scomds.size() - 1][2];
+    // 按"|"分割命令为子命令，再解析出每个子命令的参数和重定向
+    std::vector<Stage> stages;
+    if (!parse_pipeline(cmd, stages)) {
+      continue;
+    }
 
     // 没有可处理的命令
-    if (args.empty()) {
+    if (stages.empty()) {
       continue;
     }
 
-    // 退出
-    if (args[0] == "exit") {
-      if (args.size() <= 1) {
-        return 0;
+    // here-doc 的内容紧跟在命令行之后，逐行读入直到结束标记
+    for (auto &stage : stages) {
+      for (auto &redirect : stage.redirects) {
+        if (redirect.type != REDIRECT_HEREDOC) {
+          continue;
+        }
+        std::string line;
+        while (true) {
+          if (!editor.read_line("> ", line) || line == redirect.target) {
+            break;
+          }
+          redirect.body += line;
+          redirect.body += '\n';
+        }
       }
+    }
 
-      // std::string 转 int
-      std::stringstream code_stream(args[1]);
-      int code = 0;
-      code_stream >> code;  //?
-
-      // 转换失败
-      if (!code_stream.eof() || code_stream.fail()) {
-        std::cout << "Invalid exit code\n";
-        continue;
-      }
+    run_pipeline(stages, bg_command, timed, state);
 
-      return code;
+    if (state.should_exit) {
+      return state.exit_code;
     }
+  }
+}
 
-    // 打印当前工作目录
-    if (args[0] == "pwd") {
-      if (args.size() <= 1) {
-        char *cwd = getcwd(NULL, 0); // 自动分配内存
-        if (cwd) {
-          printf("Current directory: %s\n", cwd);
-          free(cwd); // 手动释放内存
-        } else {
-          perror("getcwd() error"); // perror()是 C 语言标准库中的一个函数，主要用于将系统错误信息输出到标准错误流
-        }
-        continue;
-      } else {
-        std::cout << "Invalid pwd code\n";
-        continue;
-      }
-    }
+// 解析并执行一行命令，供进程替换中的子 Shell 使用，不读入 here-doc 内容
+void run_command_line(const std::string &cmd, ShellState &state) {
+  std::vector<Stage> stages;
+  if (parse_pipeline(cmd, stages) && !stages.empty()) {
+    run_pipeline(stages, false, false, state);
+  }
+}
 
-    // 更改当前工作目录为指定目录
-    if (args[0] == "cd") {
-      if (args.size() == 1) {
-        oldwd = getcwd(NULL, 0); // 获取当前工作目录
-        if (oldwd == "") {
-          perror("getcwd() failed");
-          continue;
-        }
-        if (chdir("/home") == -1) {
-          perror("chdir() failed");
-          continue;
+// 执行一条命令（可能包含管道）
+// 只有一个子命令且为前台内建命令时，直接在 Shell 进程内执行，重定向结束后恢复标准输入输出
+// 其余情况为每个子命令 fork 一个子进程，内建命令在子进程内执行，外部命令通过 execvp 执行
+// timed 或开启了 timing 时，前台命令结束后输出资源统计；关闭时不做任何额外的系统调用
+void run_pipeline(std::vector<Stage> &stages, bool bg_command, bool timed, ShellState &state) {
+  // 后台命令不统计
+  bool report = (timed || state.report_jobs) && !bg_command;
+
+  // 进程替换需要在执行命令的进程中打开管道，因此带进程替换的内建命令也放到子进程中执行
+  if (stages.size() == 1 && !bg_command && !has_process_substitution(stages[0])) {
+    BuiltinId id = find_builtin(stages[0].args[0]);
+    if (id != BUILTIN_NONE) {
+      // 保存标准输入输出，内建命令执行完后恢复
+      // 副本设置 FD_CLOEXEC 并放在 10 以上，不会被内建命令启动的子进程（如 parallel 的任务）继承
+      // 原本就关闭的描述符（EBADF）记为 -1，恢复时同样关闭
+      int saved_fds[3];
+      bool saved = true;
+      for (int i = 0; i < 3; ++i) {
+        saved_fds[i] = fcntl(i, F_DUPFD_CLOEXEC, 10);
+        if (saved_fds[i] < 0 && errno != EBADF) {
+          saved = false;
         }
-        continue;
-      } else if (args.size() == 2) {
-        if (args[1] == "-") {
-          if (oldwd == "") {
-            std::cout << "OLDPWD not set\n";
-            continue;
-          }
-          std::string temp_oldwd = oldwd;
-          std::cout << oldwd << std::endl;
-          oldwd = getcwd(NULL, 0); // 获取当前工作目录
-          if (oldwd == "") {
-            perror("getcwd() failed");
-            continue;
-          }
-          chdir(temp_oldwd.c_str());
-          continue;
-        } else {
-          // chdir()函数的参数为*char，因此需要转换格式
-          oldwd = getcwd(NULL, 0); // 获取当前工作目录
-          if (oldwd == "") {
-            perror("getcwd() failed");
-            continue;
-          }
-          if (chdir(args[1].c_str()) == -1) {
-            perror("chdir() failed");
-            continue;
+      }
+      if (!saved) {
+        perror("dup failed");
+        for (int i = 0; i < 3; ++i) {
+          if (saved_fds[i] >= 0) {
+            close(saved_fds[i]);
           }
-          continue;
         }
-      } else {
-        std::cout << "Invalid cd code\n";
-        continue;
+        return;
       }
-    }
-
-    // 等待所有后台命令终止
-    // 如果有后台命令在运行，wait命令会阻塞，直到所有后台命令都结束
-    // 结束后输出"Process <pid> exited"
-    
-    if (args[0] == "wait") {
-      for (auto &bg_pid : bg_pids) {
-        int status;
-        pid_t ret = waitpid(bg_pid, &status, 0);
-        if (ret == -1) {
-          perror("waitpid failed");
-        } else if (WIFEXITED(status) | WIFSIGNALED(status) | WEXITSTATUS(status)) {
-          std::cout << "Process " << bg_pid << " exited " << "\n";
-          bg_pids.pop_back();//erase(bg_pids.begin()); // 将已经结束的进程从列表中删除
-        }
+      // 内建命令在 Shell 进程内执行，统计的是 Shell 自身与期间回收的子进程（如 parallel 的任务）资源用量的增量
+      std::vector<StageReport> reports(1);
+      struct rusage before, children_before;
+      if (report) {
+        reports[0].name = stages[0].args[0];
+        reports[0].builtin = true;
+        getrusage(RUSAGE_SELF, &before);
+        getrusage(RUSAGE_CHILDREN, &children_before);
+        clock_gettime(CLOCK_MONOTONIC, &reports[0].start);
       }
-      continue;
-    }
-
-    if (args[0] == "echo") {
-      if (args.size() == 1) {
-        std::cout << "\n";
-        continue;
-      } else if (args[1] == "$SHELL") {
-        if (args.size() > 2) {
-          std::cout << "Invalid echo code\n";
-          continue;
-        } 
-        uid_t uid = getuid(); // 获取当前用户的UID
-        struct passwd *pw = getpwuid(uid);  // 通过 UID 查询用户信息
-        if (pw) {
-          std::cout << pw->pw_shell << std::endl;
+      if (apply_redirections(stages[0])) {
+        run_builtin(id, stages[0].args, state);
+      }
+      std::cout.flush();
+      for (int i = 0; i < 3; ++i) {
+        if (saved_fds[i] >= 0) {
+          dup2(saved_fds[i], i);
+          close(saved_fds[i]);
         } else {
-          perror("getpwuid() failed");
+          close(i);
         }
-        continue;
-      } else {
-        for (size_t i = 1; i < args.size(); i++) {
-          std::cout << args[i] << " ";
-        }
-        std::cout << std::endl;
-        continue;
       }
+      if (report) {
+        clock_gettime(CLOCK_MONOTONIC, &reports[0].end);
+        struct rusage &after = reports[0].usage;
+        struct rusage children;
+        getrusage(RUSAGE_SELF, &after);
+        getrusage(RUSAGE_CHILDREN, &children);
+        timersub(&after.ru_utime, &before.ru_utime, &after.ru_utime);
+        timersub(&after.ru_stime, &before.ru_stime, &after.ru_stime);
+        timersub(&children.ru_utime, &children_before.ru_utime, &children.ru_utime);
+        timersub(&children.ru_stime, &children_before.ru_stime, &children.ru_stime);
+        timeradd(&after.ru_utime, &children.ru_utime, &after.ru_utime);
+        timeradd(&after.ru_stime, &children.ru_stime, &after.ru_stime);
+        after.ru_nvcsw += children.ru_nvcsw - children_before.ru_nvcsw - before.ru_nvcsw;
+        after.ru_nivcsw += children.ru_nivcsw - children_before.ru_nivcsw - before.ru_nivcsw;
+        // ru_maxrss 只有历史峰值，没有增量可减，取 Shell 与已回收子进程峰值中的较大者
+        after.ru_maxrss = std::max(after.ru_maxrss, children.ru_maxrss);
+        print_job_report(reports);
+      }
+      return;
     }
-    
-    // 处理外部命令
-    // pid_t ppid = getppid(); // 获取父进程PID
-    // 用户在终端输入命令（如 ls）
-    // Shell（父进程）调用 fork() 创建子进程
-    // 子进程调用 execvp() 执行 ls 命令，父进程通过 wait() 等待子进程结束
-    // 效果：用户可以在不关闭 Shell 的情况下运行其他程序
+  }
 
-    // 父进程调用 fork() 后，操作系统会复制父进程的上下文（如内存、文件描述符等），生成子进程
-    // 子进程从 fork() 的返回点开始执行，但两者的返回值不同
+  // 子进程会继承输出缓冲区，fork 前先清空
+  std::cout.flush();
+
+  // 用来储存父进程(Shell)的PID
+  pid_t ppid = getpid();
+  // 整条管道的进程组号，等于第一个子进程的PID
+  pid_t pgid = 0;
+  // 上一个管道的读端
+  int prev_read = -1;
+  std::vector<pid_t> pids;
+  std::vector<StageReport> reports;
+
+  for (size_t i = 0; i < stages.size(); ++i) {
+    // 为创建管道而设置的数组
+    int fd[2] = {-1, -1};
+    if (i < stages.size() - 1 && pipe(fd) == -1) {
+      perror("pipe failed");
+      break;
+    }
 
-    // fork() 用于创建一个与父进程几乎完全相同的子进程
-    // 调用后，父进程和子进程会并行执行后续代码
     // fork() 会给父进程和子进程均返回一个返回值
-    // 父进程收到的的返回值为子进程的PID（进程ID）
-    // 子进程收到的的返回值为 0
-    // 创建失败时返回 -1
+    // 父进程收到的的返回值为子进程的PID，子进程收到的的返回值为 0，创建失败时返回 -1
     pid_t pid = fork();
-    
     if (pid < 0) {
       perror("fork failed");
-      continue;
+      if (fd[0] != -1) {
+        close(fd[0]);
+        close(fd[1]);
+      }
+      break;
     } else if (pid == 0) {
       // 子进程
-      setpgid(0, 0); // 将子进程设置为一个新的进程组
+      // 同一条管道的子进程放入同一个进程组
+      if (state.job_control) {
+        setpgid(0, pgid);
+      }
 
       // 如果命令是后台执行的，设置父进程设置为前台进程组
       // 并且避免后台进程与终端交互
-      // 如果命令不是后台执行的，设置子进程为前台进程组
+      // 如果命令不是后台执行的，设置子进程组为前台进程组
       if (!bg_command) {
-        tcsetpgrp(STDIN_FILENO, getpgid(0)); // 将子进程组设置为当前终端的前台进程组
+        if (state.job_control) {
+          tcsetpgrp(STDIN_FILENO, getpgid(0));
+        }
       } else {
-        tcsetpgrp(STDIN_FILENO, ppid); 
+        tcsetpgrp(STDIN_FILENO, ppid);
         int null_fd = open("/dev/null", O_RDWR);
         dup2(null_fd, STDIN_FILENO);
         dup2(null_fd, STDOUT_FILENO);
@@ -254,136 +432,967 @@ int main() {
       signal(SIGINT, SIG_DFL);
       signal(SIGTTOU, SIG_DFL);
 
-      // 如果命令中有" | "，创建管道
-      if (scomds.size() > 1) {
-        for (size_t i = 0; i < scomds.size() - 1; ++i)
-          if (pipe(fd[i]) == -1) {
-            perror("pipe failed");
-            continue;
-          }
-      } 
+      // 实现管道功能
+      if (prev_read != -1) {
+        dup2(prev_read, STDIN_FILENO);
+        close(prev_read);
+      }
+      if (fd[1] != -1) {
+        dup2(fd[1], STDOUT_FILENO);
+        close(fd[0]);
+        close(fd[1]);
+      }
 
-      for (size_t i = 0; i < scomds.size(); ++i) {
-        // 创建子进程执行指令
-        pid_t cpid = fork();
-        if (cpid < 0) {
-          perror("fork failed");
-          continue;
-        } else if (cpid == 0) {
-          // 实现管道功能
-          if (scomds.size() > 1) {
-            // 输入重定向
-            if (i > 0) {
-              dup2(fd[i-1][0], STDIN_FILENO);
-              close(fd[i-1][1]);
-            }
-            // 输出重定向
-            if (i < scomds.size() - 1) {
-              dup2(fd[i][1], STDOUT_FILENO);
-              close(fd[i][0]);
-            }
-          }
+      // 先展开进程替换，重定向目标也可以是进程替换，如 "> >(cmd)"
+      std::vector<std::string> targets;
+      std::vector<bool> targets_quoted;
+      for (auto &redirect : stages[i].redirects) {
+        bool is_file = redirect.type != REDIRECT_HEREDOC && redirect.type != REDIRECT_HERESTRING;
+        targets.push_back(is_file ? redirect.target : "");
+        targets_quoted.push_back(redirect.quoted);
+      }
+      if (!expand_process_substitutions(stages[i].args, stages[i].quoted, state) ||
+          !expand_process_substitutions(targets, targets_quoted, state)) {
+        exit(1);
+      }
+      for (size_t j = 0; j < targets.size(); ++j) {
+        if (!targets[j].empty()) {
+          stages[i].redirects[j].target = targets[j];
+        }
+      }
+      if (!apply_redirections(stages[i])) {
+        exit(1);
+      }
 
-          // 存储分割后的子命令参数
-          std::vector<std::string> scomd_args = split(scomds[i], " ");
-          // 实现重定向功能
-          // 访问权限为 0644 表示文件所有者可读写, 其他用户只读
-          // 更改指定内容为" "，防止重定向文件名被当作参数
-          for (size_t i = 0; i < scomd_args.size(); i++) {
-            if (scomd_args[i] == "<") {
-              int fd = open(scomd_args[i+1].c_str(), O_RDONLY, 0644);
-              if (fd < 0) {
-                perror("open failed");
-                continue;
-              } else {
-                dup2(fd, STDIN_FILENO);
-                close(fd);
-              }
-              scomd_args[i] = " ";
-              scomd_args[i+1] = " ";
-            }
-            if (scomd_args[i] == ">>") {
-              int fd = open(scomd_args[i+1].c_str(), O_CREAT | O_WRONLY | O_APPEND, 0644);
-              if (fd < 0) {
-                perror("open failed");
-                continue;
-              } else {
-                dup2(fd, STDOUT_FILENO);
-                close(fd);
-              }
-              scomd_args[i] = " ";
-              scomd_args[i+1] = " ";
-            }
-            if (scomd_args[i] == ">") {
-              int fd = open(scomd_args[i+1].c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
-              if (fd < 0) {
-                perror("open failed");
-                continue;
-              } else {
-                dup2(fd, STDOUT_FILENO);
-                close(fd);
-              }
-              scomd_args[i] = " ";
-              scomd_args[i+1] = " ";
-            }
-          }
+      // 内建命令直接在子进程中执行，省去一次 execvp
+      BuiltinId id = find_builtin(stages[i].args[0]);
+      if (id != BUILTIN_NONE) {
+        int code = run_builtin(id, stages[i].args, state);
+        std::cout.flush();
+        exit(code);
+      }
 
-          // 执行子命令
-          std::vector<char*> argv; // 存储转换为C风格字符串的指针
-          // 遍历 scomd_args 中的每个元素, auto& 声明引用以避免拷贝
-          for (auto& arg : scomd_args) {
-            // 屏蔽掉额外添加的" "
-            if (arg != " ")
-              argv.push_back(const_cast<char*>(arg.c_str())); // execvp 函数要求第一个参数是 const char*, 强制移除
-          }
-          argv.push_back(nullptr); // execvp 系列的 argv 需要以 nullptr 结尾
-
-          // execvp 会完全更换子进程接下来的代码，所以正常情况下 execvp 之后这里的代码就没意义了
-          // 如果 execvp 之后的代码被运行了，那就是 execvp 出问题了
-          execvp(argv[0], argv.data());
-          // 所以这里直接报错
-          perror("execvp failed");
-          exit(255);
-        } else {
-          // 父进程
-          // 关闭上一个命令的读端和写端，防止阻塞
-          close(fd[i-1][0]);
-          close(fd[i-1][1]);
+      // 执行子命令
+      std::vector<char*> argv; // 存储转换为C风格字符串的指针
+      // 遍历子命令参数, auto& 声明引用以避免拷贝
+      for (auto& arg : stages[i].args) {
+        argv.push_back(const_cast<char*>(arg.c_str())); // execvp 函数要求第一个参数是 const char*, 强制移除
+      }
+      argv.push_back(nullptr); // execvp 系列的 argv 需要以 nullptr 结尾
+
+      // execvp 会完全更换子进程接下来的代码，所以正常情况下 execvp 之后这里的代码就没意义了
+      // 如果 execvp 之后的代码被运行了，那就是 execvp 出问题了
+      execvp(argv[0], argv.data());
+      // 所以这里直接报错
+      perror("execvp failed");
+      exit(255);
+    }
+
+    // 父进程
+    // 父子进程都设置一次进程组，避免竞争
+    if (state.job_control) {
+      if (pgid == 0) {
+        pgid = pid;
+      }
+      setpgid(pid, pgid);
+    }
+    pids.push_back(pid);
+    if (report) {
+      reports.push_back(StageReport());
+      reports.back().name = stages[i].args[0];
+      clock_gettime(CLOCK_MONOTONIC, &reports.back().start);
+    }
+
+    // 关闭已经交给子进程的管道端，防止阻塞
+    if (prev_read != -1) {
+      close(prev_read);
+    }
+    if (fd[1] != -1) {
+      close(fd[1]);
+    }
+    prev_read = fd[0];
+  }
+  if (prev_read != -1) {
+    close(prev_read);
+  }
+
+  if (bg_command) {
+    // 将子进程的PID添加到后台进程列表
+    // 跳过等待，实现"允许启动更多进程而无需等待后台进程完成"功能
+    state.bg_pids.insert(state.bg_pids.end(), pids.begin(), pids.end());
+    return;
+  }
+
+  // 父进程：设置子进程组为前台并等待
+  if (pgid != 0) {
+    tcsetpgrp(STDIN_FILENO, pgid);
+  }
+
+  // 有作业控制时按进程组回收，先结束的子命令先被回收，这样统计到的结束时刻是准确的
+  // wait4 与 waitpid 是同一个系统调用，不统计时传入空指针，没有额外开销
+  bool signaled = false;
+  size_t remaining = pids.size();
+  while (remaining > 0) {
+    pid_t target = state.job_control ? -pgid : pids[pids.size() - remaining];
+    int status;
+    struct rusage usage;
+    pid_t pid = wait4(target, &status, 0, report ? &usage : nullptr);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("wait4 failed");
+      break;
+    }
+    remaining--;
+    if (WIFSIGNALED(status)) {
+      signaled = true;
+    }
+    if (report) {
+      for (size_t i = 0; i < pids.size(); ++i) {
+        if (pids[i] == pid) {
+          clock_gettime(CLOCK_MONOTONIC, &reports[i].end);
+          reports[i].usage = usage;
         }
       }
-      if (scomds.size() > 1) {
-        // 关闭最后一个管道的读端与写端
-        close(fd[scomds.size()-2][1]);
+    }
+  }
+
+  // 恢复 Shell 的前台控制
+  tcsetpgrp(STDIN_FILENO, getpgrp());
+
+  if (signaled) {
+    std::cout << "\n";
+  }
+  if (report) {
+    print_job_report(reports);
+  }
+}
+
+// 命令以 time 关键字开头时去掉该关键字并返回 true
+bool strip_time_keyword(std::string &cmd) {
+  size_t start = cmd.find_first_not_of(" \t");
+  if (start == std::string::npos || cmd.compare(start, 4, "time") != 0) {
+    return false;
+  }
+  size_t end = start + 4;
+  if (end < cmd.size() && cmd[end] != ' ' && cmd[end] != '\t') {
+    return false;
+  }
+  cmd.erase(0, end);
+  return true;
+}
+
+double timespec_seconds(const struct timespec &t) {
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+double timeval_seconds(const struct timeval &t) {
+  return t.tv_sec + t.tv_usec / 1e6;
+}
+
+// 向标准错误输出每个子命令的墙钟时间、用户态/内核态 CPU 时间、最大常驻内存和上下文切换次数
+// 最后一行汇总整条命令：墙钟时间从第一个子进程创建到最后一个子进程回收，其余各项求和或取最大值
+void print_job_report(const std::vector<StageReport> &reports) {
+  if (reports.empty()) {
+    return;
+  }
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << std::left << std::setw(8) << "stage" << std::setw(16) << "command"
+      << std::right << std::setw(10) << "real" << std::setw(10) << "user" << std::setw(10) << "sys"
+      << std::setw(12) << "maxrss(KB)" << std::setw(8) << "vcsw" << std::setw(8) << "ivcsw" << "\n";
+
+  double first_start = timespec_seconds(reports[0].start), last_end = 0;
+  double total_user = 0, total_sys = 0;
+  long max_rss = 0, total_vcsw = 0, total_ivcsw = 0;
+  bool has_builtin = false;
+  for (size_t i = 0; i < reports.size(); ++i) {
+    const StageReport &r = reports[i];
+    double start = timespec_seconds(r.start), end = timespec_seconds(r.end);
+    double user = timeval_seconds(r.usage.ru_utime), sys = timeval_seconds(r.usage.ru_stime);
+    first_start = std::min(first_start, start);
+    last_end = std::max(last_end, end);
+    total_user += user;
+    total_sys += sys;
+    max_rss = std::max(max_rss, r.usage.ru_maxrss);
+    total_vcsw += r.usage.ru_nvcsw;
+    total_ivcsw += r.usage.ru_nivcsw;
+    has_builtin = has_builtin || r.builtin;
+    std::string name = r.builtin ? r.name.substr(0, 14) + "*" : r.name.substr(0, 15);
+    out << std::left << std::setw(8) << i + 1 << std::setw(16) << name
+        << std::right << std::setw(9) << end - start << "s" << std::setw(9) << user << "s"
+        << std::setw(9) << sys << "s" << std::setw(12) << r.usage.ru_maxrss
+        << std::setw(8) << r.usage.ru_nvcsw << std::setw(8) << r.usage.ru_nivcsw << "\n";
+  }
+  if (reports.size() > 1) {
+    out << std::left << std::setw(8) << "total" << std::setw(16) << ""
+        << std::right << std::setw(9) << last_end - first_start << "s" << std::setw(9) << total_user << "s"
+        << std::setw(9) << total_sys << "s" << std::setw(12) << max_rss
+        << std::setw(8) << total_vcsw << std::setw(8) << total_ivcsw << "\n";
+  }
+  if (has_builtin) {
+    out << "* builtin runs in the shell: user/sys/vcsw include children reaped meanwhile; "
+        << "maxrss is the peak since the shell started\n";
+  }
+  std::cerr << out.str();
+}
+
+// 按名字查找内建命令
+// 在 builtin_index 中按长度、首字母和末字母散列，通常一次字符串比较就能确定
+BuiltinId find_builtin(const std::string &name) {
+  if (name.empty()) {
+    return BUILTIN_NONE;
+  }
+  for (size_t h = builtin_hash(name.data(), name.size()); builtin_index.slots[h] != BUILTIN_NONE;
+       h = (h + 1) % builtin_slots) {
+    BuiltinId id = builtin_index.slots[h];
+    if (name == builtin_table[id - 1].name) {
+      return id;
+    }
+  }
+  return BUILTIN_NONE;
+}
+
+int run_builtin(BuiltinId id, std::vector<std::string> &args, ShellState &state) {
+  return builtin_table[id - 1].func(args, state);
+}
+
+// 按不在引号和进程替换内的"|"分割命令为子命令
+// 只有 "<(" 和 ">(" 开启的括号才计入层数，进程替换之外的普通括号只是字符
+// 引号或进程替换的括号不配对时返回 false
+bool split_pipeline(const std::string &cmd, std::vector<std::string> &scomds) {
+  std::string cur;
+  char quote = 0;
+  int depth = 0;
+  for (char c : cmd) {
+    if (quote) {
+      if (c == quote) {
+        quote = 0;
+      }
+    } else if (c == '\'' || c == '"') {
+      quote = c;
+    } else if (c == '(' && (depth > 0 || (!cur.empty() && (cur.back() == '<' || cur.back() == '>')))) {
+      depth++;
+    } else if (c == ')' && depth > 0) {
+      depth--;
+    } else if (c == '|' && depth == 0) {
+      scomds.push_back(cur);
+      cur.clear();
+      continue;
+    }
+    cur += c;
+  }
+  scomds.push_back(cur);
+  if (quote || depth != 0) {
+    std::cout << "Unmatched quote or parenthesis\n";
+    return false;
+  }
+  return true;
+}
+
+// 按空白分割子命令为单词
+// 引号内的空白不分割，引号本身被去掉；"<(...)" 和 ">(...)" 整体作为一个单词保留
+// quoted[i] 表示第 i 个单词是否含有引号，含有引号的 ">" 等只是普通参数，不是重定向
+bool tokenize(const std::string &s, std::vector<std::string> &words, std::vector<bool> &quoted) {
+  size_t i = 0;
+  while (i < s.size()) {
+    if (s[i] == ' ' || s[i] == '\t') {
+      i++;
+      continue;
+    }
+
+    // 进程替换，保留括号交给 expand_process_substitutions 处理
+    if ((s[i] == '<' || s[i] == '>') && i + 1 < s.size() && s[i+1] == '(') {
+      size_t start = i;
+      int depth = 0;
+      char quote = 0;
+      for (i += 1; i < s.size(); i++) {
+        if (quote) {
+          if (s[i] == quote) quote = 0;
+        } else if (s[i] == '\'' || s[i] == '"') {
+          quote = s[i];
+        } else if (s[i] == '(') {
+          depth++;
+        } else if (s[i] == ')' && --depth == 0) {
+          break;
+        }
       }
-      while (wait(nullptr) > 0); // 等待所有子进程结束
-      return 0;
-    } else {    
-      // 这里只有 Shell 才会进入
-      // 父进程调用 wait(nullptr) 阻塞等待子进程结束，并回收其资源
-      // 成功：返回终止的子进程PID
-      // 失败：返回 -1（如无子进程或信号中断）
-      // 父进程：设置子进程组为前台并等待
-      if (bg_command) {
-        bg_pids.push_back(pid); // 将子进程的PID添加到后台进程列表;
-        continue; // 跳过，实现"允许启动更多进程而无需等待后台进程完成"功能
+      if (i >= s.size()) {
+        return false;
       }
+      words.push_back(s.substr(start, ++i - start));
+      quoted.push_back(false);
+      continue;
+    }
 
-      setpgid(pid, pid);
-      tcsetpgrp(STDIN_FILENO, pid);
+    std::string word;
+    bool has_quote = false;
+    while (i < s.size() && s[i] != ' ' && s[i] != '\t') {
+      if (s[i] == '\'' || s[i] == '"') {
+        size_t end = s.find(s[i], i + 1);
+        if (end == std::string::npos) {
+          return false;
+        }
+        word += s.substr(i + 1, end - i - 1);
+        i = end + 1;
+        has_quote = true;
+      } else {
+        word += s[i++];
+      }
+    }
+    words.push_back(word);
+    quoted.push_back(has_quote);
+  }
+  return true;
+}
 
-      int status;
-      int ret = waitpid(pid, &status, 0);
+// 解析一行命令：分割子命令，并把重定向从参数中分离出来
+// 语法错误时输出提示并返回 false；空行得到空的 stages
+bool parse_pipeline(const std::string &cmd, std::vector<Stage> &stages) {
+  std::vector<std::string> scomds;
+  if (!split_pipeline(cmd, scomds)) {
+    return false;
+  }
 
-      // 恢复 Shell 的前台控制
-      tcsetpgrp(STDIN_FILENO, getpgrp());
+  for (auto &scomd : scomds) {
+    std::vector<std::string> words;
+    std::vector<bool> quoted;
+    if (!tokenize(scomd, words, quoted)) {
+      std::cout << "Unmatched quote or parenthesis\n";
+      return false;
+    }
+    // 整行为空
+    if (words.empty() && scomds.size() == 1) {
+      return true;
+    }
 
-      if (ret < 0) {
-        perror("waitpid failed");
-      } else if (WIFSIGNALED(status)) {
-        std::cout << "\n";
+    Stage stage;
+    for (size_t i = 0; i < words.size(); i++) {
+      Redirect redirect;
+      if (quoted[i]) {
+        stage.args.push_back(words[i]);
+        stage.quoted.push_back(true);
+        continue;
+      } else if (words[i] == "<") {
+        redirect.type = REDIRECT_IN;
+      } else if (words[i] == ">") {
+        redirect.type = REDIRECT_OUT;
+      } else if (words[i] == ">>") {
+        redirect.type = REDIRECT_APPEND;
+      } else if (words[i] == "<<") {
+        redirect.type = REDIRECT_HEREDOC;
+      } else if (words[i] == "<<<") {
+        redirect.type = REDIRECT_HERESTRING;
+      } else {
+        stage.args.push_back(words[i]);
+        stage.quoted.push_back(false);
+        continue;
+      }
+      if (i + 1 >= words.size()) {
+        std::cout << "Missing redirection target\n";
+        return false;
       }
+      redirect.target = words[++i];
+      redirect.quoted = quoted[i];
+      stage.redirects.push_back(redirect);
     }
+
+    if (stage.args.empty()) {
+      std::cout << "Invalid pipeline\n";
+      return false;
+    }
+    stages.push_back(stage);
   }
+  return true;
+}
+
+bool is_process_substitution(const std::string &word) {
+  return word.size() >= 3 && (word[0] == '<' || word[0] == '>') && word[1] == '(' && word.back() == ')';
+}
+
+bool has_process_substitution(const Stage &stage) {
+  for (size_t i = 0; i < stage.args.size(); ++i) {
+    if (!stage.quoted[i] && is_process_substitution(stage.args[i])) {
+      return true;
+    }
+  }
+  for (auto &redirect : stage.redirects) {
+    if (!redirect.quoted && is_process_substitution(redirect.target)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// 实现进程替换功能
+// "<(cmd)" 把 cmd 的输出接到一个管道上，">(cmd)" 把管道接到 cmd 的输入上
+// 参数被替换为管道在当前进程中的路径 /dev/fd/N，数据不经过文件系统
+// 必须在最终执行命令的进程中调用，管道描述符才能被 execvp 后的程序继承
+// quoted[i] 为 true 的参数是用户加了引号的文本，原样保留，绝不执行
+bool expand_process_substitutions(std::vector<std::string> &args, const std::vector<bool> &quoted,
+                                  ShellState &state) {
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string &arg = args[i];
+    if (quoted[i] || !is_process_substitution(arg)) {
+      continue;
+    }
+    bool is_input = arg[0] == '<';
+    std::string inner = arg.substr(2, arg.size() - 3);
+
+    int fd[2];
+    if (pipe(fd) == -1) {
+      perror("pipe failed");
+      return false;
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork failed");
+      close(fd[0]);
+      close(fd[1]);
+      return false;
+    } else if (pid == 0) {
+      // 子 Shell：执行替换中的命令
+      if (is_input) {
+        dup2(fd[1], STDOUT_FILENO);
+      } else {
+        dup2(fd[0], STDIN_FILENO);
+      }
+      close(fd[0]);
+      close(fd[1]);
+      state.job_control = false;
+      state.bg_pids.clear();
+      run_command_line(inner, state);
+      std::cout.flush();
+      exit(0);
+    }
+
+    // 当前进程保留管道的另一端
+    int keep = is_input ? fd[0] : fd[1];
+    close(is_input ? fd[1] : fd[0]);
+    arg = "/dev/fd/" + std::to_string(keep);
+  }
+  return true;
+}
+
+// 把一段内存中的数据变为可读的文件描述符，数据不落盘
+// 数据能一次放进空管道时直接写入管道；否则写入 memfd，
+// 这样写入方不必等待读者，读者也不会因为管道写满而与写入方互相等待
+int open_data_fd(const std::string &data) {
+  int fd[2];
+  if (pipe(fd) == -1) {
+    perror("pipe failed");
+    return -1;
+  }
+  long capacity = fcntl(fd[1], F_GETPIPE_SZ);
+  if (capacity > 0 && data.size() <= (size_t)capacity) {
+    if (!data.empty() && write(fd[1], data.data(), data.size()) != (ssize_t)data.size()) {
+      perror("write failed");
+      close(fd[0]);
+      close(fd[1]);
+      return -1;
+    }
+    close(fd[1]);
+    return fd[0];
+  }
+  close(fd[0]);
+  close(fd[1]);
+
+  int mfd = memfd_create("here-document", 0);
+  if (mfd < 0) {
+    perror("memfd_create failed");
+    return -1;
+  }
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = write(mfd, data.data() + written, data.size() - written);
+    if (n < 0) {
+      perror("write failed");
+      close(mfd);
+      return -1;
+    }
+    written += n;
+  }
+  lseek(mfd, 0, SEEK_SET);
+  return mfd;
+}
+
+// 实现重定向功能
+// 访问权限为 0644 表示文件所有者可读写, 其他用户只读
+// here-doc 和 here-string 的内容通过 open_data_fd 接到标准输入
+// 打开失败时返回 false
+bool apply_redirections(Stage &stage) {
+  for (auto &redirect : stage.redirects) {
+    int fd, target;
+    switch (redirect.type) {
+      case REDIRECT_IN:
+        fd = open(redirect.target.c_str(), O_RDONLY, 0644);
+        target = STDIN_FILENO;
+        break;
+      case REDIRECT_OUT:
+        fd = open(redirect.target.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+        target = STDOUT_FILENO;
+        break;
+      case REDIRECT_APPEND:
+        fd = open(redirect.target.c_str(), O_CREAT | O_WRONLY | O_APPEND, 0644);
+        target = STDOUT_FILENO;
+        break;
+      case REDIRECT_HEREDOC:
+        fd = open_data_fd(redirect.body);
+        target = STDIN_FILENO;
+        break;
+      case REDIRECT_HERESTRING:
+        fd = open_data_fd(redirect.target + "\n");
+        target = STDIN_FILENO;
+        break;
+      default:
+        return false;
+    }
+    if (fd < 0) {
+      if (redirect.type != REDIRECT_HEREDOC && redirect.type != REDIRECT_HERESTRING) {
+        perror("open failed");
+      }
+      return false;
+    }
+    // 重定向前清空缓冲区，避免之前的输出写入新文件
+    std::cout.flush();
+    dup2(fd, target);
+    close(fd);
+  }
+  return true;
+}
+
+// 获取当前工作目录，失败时返回空串
+std::string get_cwd() {
+  char *cwd = getcwd(NULL, 0); // 自动分配内存
+  if (!cwd) {
+    return "";
+  }
+  std::string res(cwd);
+  free(cwd); // 手动释放内存
+  return res;
+}
+
+// 退出
+int builtin_exit(const std::vector<std::string> &args, ShellState &state) {
+  if (args.size() <= 1) {
+    state.should_exit = true;
+    state.exit_code = 0;
+    return 0;
+  }
+
+  // std::string 转 int
+  std::stringstream code_stream(args[1]);
+  int code = 0;
+  code_stream >> code;
+
+  // 转换失败
+  if (!code_stream.eof() || code_stream.fail()) {
+    std::cout << "Invalid exit code\n";
+    return 1;
+  }
+
+  state.should_exit = true;
+  state.exit_code = code;
+  return code;
+}
+
+// 打印当前工作目录
+int builtin_pwd(const std::vector<std::string> &args, ShellState &) {
+  if (args.size() > 1) {
+    std::cout << "Invalid pwd code\n";
+    return 1;
+  }
+  std::string cwd = get_cwd();
+  if (cwd.empty()) {
+    perror("getcwd() error"); // perror()是 C 语言标准库中的一个函数，主要用于将系统错误信息输出到标准错误流
+    return 1;
+  }
+  std::cout << "Current directory: " << cwd << "\n";
+  return 0;
+}
+
+// 更改当前工作目录为指定目录
+// 没有参数时进入家目录，"cd -" 切换为上一次所在的目录
+int builtin_cd(const std::vector<std::string> &args, ShellState &state) {
+  if (args.size() > 2) {
+    std::cout << "Invalid cd code\n";
+    return 1;
+  }
+
+  std::string target;
+  if (args.size() == 1) {
+    target = "/home";
+  } else if (args[1] == "-") {
+    if (state.oldwd.empty()) {
+      std::cout << "OLDPWD not set\n";
+      return 1;
+    }
+    target = state.oldwd;
+    std::cout << target << std::endl;
+  } else {
+    target = args[1];
+  }
+
+  std::string cwd = get_cwd(); // 获取当前工作目录
+  if (cwd.empty()) {
+    perror("getcwd() failed");
+    return 1;
+  }
+  // chdir()函数的参数为*char，因此需要转换格式
+  if (chdir(target.c_str()) == -1) {
+    perror("chdir() failed");
+    return 1;
+  }
+  state.oldwd = cwd;
+  return 0;
+}
+
+// 等待所有后台命令终止
+// 如果有后台命令在运行，wait命令会阻塞，直到所有后台命令都结束
+// 结束后输出"Process <pid> exited"
+int builtin_wait(const std::vector<std::string> &, ShellState &state) {
+  for (auto &bg_pid : state.bg_pids) {
+    int status;
+    pid_t ret = waitpid(bg_pid, &status, 0);
+    if (ret == -1) {
+      perror("waitpid failed");
+    } else {
+      std::cout << "Process " << bg_pid << " exited " << "\n";
+    }
+  }
+  // 已经结束的进程从列表中删除
+  state.bg_pids.clear();
+  return 0;
+}
+
+// 输出参数，echo $SHELL 输出当前用户的登录 Shell
+int builtin_echo(const std::vector<std::string> &args, ShellState &) {
+  if (args.size() > 1 && args[1] == "$SHELL") {
+    if (args.size() > 2) {
+      std::cout << "Invalid echo code\n";
+      return 1;
+    }
+    uid_t uid = getuid(); // 获取当前用户的UID
+    struct passwd *pw = getpwuid(uid);  // 通过 UID 查询用户信息
+    if (!pw) {
+      perror("getpwuid() failed");
+      return 1;
+    }
+    std::cout << pw->pw_shell << std::endl;
+    return 0;
+  }
+  for (size_t i = 1; i < args.size(); i++) {
+    if (i > 1) {
+      std::cout << " ";
+    }
+    std::cout << args[i];
+  }
+  std::cout << "\n";
+  return 0;
+}
+
+// 开关每个前台命令结束后的资源统计：timing on / timing off，无参数时输出当前状态
+int builtin_timing(const std::vector<std::string> &args, ShellState &state) {
+  if (args.size() == 1) {
+    std::cout << "timing " << (state.report_jobs ? "on" : "off") << "\n";
+    return 0;
+  }
+  if (args.size() == 2 && args[1] == "on") {
+    state.report_jobs = true;
+    return 0;
+  }
+  if (args.size() == 2 && args[1] == "off") {
+    state.report_jobs = false;
+    return 0;
+  }
+  std::cout << "Invalid timing code\n";
+  return 1;
+}
+
+// 把数据完整写入 fd
+bool write_all(int fd, const std::string &data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = write(fd, data.data() + written, data.size() - written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    written += n;
+  }
+  return true;
+}
+
+// 为 parallel 启动一个任务：命令中的 "{}" 替换为输入，没有 "{}" 时把输入追加为最后一个参数
+// 子进程的标准输出和标准错误接到两个管道上，标准输入接到 /dev/null，避免任务之间争抢输入
+bool spawn_parallel_job(const std::vector<std::string> &cmd, ParallelJob &job, ShellState &state) {
+  std::vector<std::string> args;
+  bool replaced = false;
+  for (auto &arg : cmd) {
+    size_t pos = arg.find("{}");
+    if (pos == std::string::npos) {
+      args.push_back(arg);
+      continue;
+    }
+    std::string expanded = arg;
+    for (; pos != std::string::npos; pos = expanded.find("{}", pos + job.input.size())) {
+      expanded.replace(pos, 2, job.input);
+    }
+    args.push_back(expanded);
+    replaced = true;
+  }
+  if (!replaced) {
+    args.push_back(job.input);
+  }
+
+  // 管道设置 O_CLOEXEC，防止被其它任务继承而迟迟读不到 EOF
+  int out[2], err[2];
+  if (pipe2(out, O_CLOEXEC) == -1) {
+    perror("pipe failed");
+    return false;
+  }
+  if (pipe2(err, O_CLOEXEC) == -1) {
+    perror("pipe failed");
+    close(out[0]);
+    close(out[1]);
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork failed");
+    close(out[0]);
+    close(out[1]);
+    close(err[0]);
+    close(err[1]);
+    return false;
+  } else if (pid == 0) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+    // parallel 为了用 signalfd 接收 SIGCHLD 屏蔽了它，屏蔽字会被子进程继承
+    sigset_t chld;
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    sigprocmask(SIG_UNBLOCK, &chld, nullptr);
+    int null_fd = open("/dev/null", O_RDONLY);
+    dup2(null_fd, STDIN_FILENO);
+    close(null_fd);
+    dup2(out[1], STDOUT_FILENO);
+    dup2(err[1], STDERR_FILENO);
+
+    BuiltinId id = find_builtin(args[0]);
+    if (id != BUILTIN_NONE) {
+      int code = run_builtin(id, args, state);
+      std::cout.flush();
+      exit(code);
+    }
+    std::vector<char*> argv;
+    for (auto &arg : args) {
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execvp(argv[0], argv.data());
+    perror("execvp failed");
+    exit(127);
+  }
+
+  close(out[1]);
+  close(err[1]);
+  job.pid = pid;
+  job.exited = false;
+  job.status = 0;
+  job.out_fd = out[0];
+  job.err_fd = err[0];
+  return true;
+}
+
+// 并行执行命令：parallel [-j N] cmd [args...] [::: input...]
+// 每个输入执行一次 cmd，同时最多运行 N 个任务（默认为 CPU 核数），有任务结束就启动下一个
+// 没有 ":::" 时从标准输入按行读取输入
+// 子进程退出由 signalfd 收到的 SIGCHLD 通知，和输出管道一起 poll：
+// 子进程一退出就回收并空出名额，即使它提前关闭了输出或把管道留给了仍在运行的后代进程
+// 每个任务的输出缓存到子进程退出且管道读完后整体输出，失败的任务在标准错误中报告
+int builtin_parallel(const std::vector<std::string> &args, ShellState &state) {
+  long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t i = 1;
+  for (; i < args.size() && args[i].size() > 1 && args[i][0] == '-'; ++i) {
+    std::string value;
+    if (args[i] == "-j" || args[i] == "-P") {
+      if (i + 1 >= args.size()) {
+        std::cout << "Invalid parallel code\n";
+        return 1;
+      }
+      value = args[++i];
+    } else if (args[i].compare(0, 2, "-j") == 0 || args[i].compare(0, 2, "-P") == 0) {
+      value = args[i].substr(2);
+    } else {
+      std::cout << "Invalid parallel code\n";
+      return 1;
+    }
+    std::stringstream jobs_stream(value);
+    jobs_stream >> jobs;
+    if (!jobs_stream.eof() || jobs_stream.fail() || jobs <= 0) {
+      std::cout << "Invalid parallel code\n";
+      return 1;
+    }
+  }
+
+  std::vector<std::string> cmd, inputs;
+  bool from_args = false;
+  for (; i < args.size(); ++i) {
+    if (args[i] == ":::") {
+      from_args = true;
+    } else if (from_args) {
+      inputs.push_back(args[i]);
+    } else {
+      cmd.push_back(args[i]);
+    }
+  }
+  if (cmd.empty()) {
+    std::cout << "Invalid parallel code\n";
+    return 1;
+  }
+
+  if (!from_args) {
+    // 直接读标准输入，不经过 std::cin 的缓冲区
+    std::string data;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(STDIN_FILENO, buf, sizeof(buf))) != 0) {
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        perror("read failed");
+        return 1;
+      }
+      data.append(buf, n);
+    }
+    inputs = split(data, "\n");
+  }
+
+  // 任务的输出直接写到 fd，先清空之前的输出
+  std::cout.flush();
+
+  // 屏蔽 SIGCHLD 后改由 signalfd 读取，子进程在屏蔽之后才创建，不会漏掉退出通知
+  sigset_t chld, old_mask;
+  sigemptyset(&chld);
+  sigaddset(&chld, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &chld, &old_mask);
+  int sig_fd = signalfd(-1, &chld, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (sig_fd < 0) {
+    perror("signalfd failed");
+    sigprocmask(SIG_SETMASK, &old_mask, nullptr);
+    return 1;
+  }
+
+  // running 中包括已退出但管道还没读完的任务，active 是其中尚未退出的个数
+  std::vector<ParallelJob> running;
+  size_t next = 0, failed = 0, active = 0;
+  while (next < inputs.size() || !running.empty()) {
+    // 补满空闲的位置
+    while (next < inputs.size() && active < (size_t)jobs) {
+      ParallelJob job;
+      job.index = next + 1;
+      job.input = inputs[next++];
+      if (!spawn_parallel_job(cmd, job, state)) {
+        failed++;
+        continue;
+      }
+      running.push_back(job);
+      active++;
+    }
+    if (running.empty()) {
+      break;
+    }
+
+    std::vector<struct pollfd> fds;
+    std::vector<int *> owners;
+    fds.push_back({sig_fd, POLLIN, 0});
+    owners.push_back(nullptr);
+    for (auto &job : running) {
+      for (int *fd : {&job.out_fd, &job.err_fd}) {
+        if (*fd != -1) {
+          fds.push_back({*fd, POLLIN, 0});
+          owners.push_back(fd);
+        }
+      }
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("poll failed");
+      break;
+    }
+
+    // 多个子进程的 SIGCHLD 可能合并为一个，读空 signalfd 后逐个非阻塞地检查尚未回收的任务
+    // 只回收 parallel 自己的子进程，Shell 的后台任务留给 wait
+    if (fds[0].revents) {
+      struct signalfd_siginfo info;
+      while (read(sig_fd, &info, sizeof(info)) > 0);
+      for (auto &job : running) {
+        if (!job.exited && waitpid(job.pid, &job.status, WNOHANG) > 0) {
+          job.exited = true;
+          active--;
+        }
+      }
+    }
+
+    for (size_t k = 1; k < fds.size(); ++k) {
+      if (!fds[k].revents) {
+        continue;
+      }
+      for (auto &job : running) {
+        if (owners[k] != &job.out_fd && owners[k] != &job.err_fd) {
+          continue;
+        }
+        std::string &buffer = owners[k] == &job.out_fd ? job.out : job.err;
+        char buf[65536];
+        ssize_t n = read(fds[k].fd, buf, sizeof(buf));
+        if (n > 0) {
+          buffer.append(buf, n);
+        } else if (n == 0 || errno != EINTR) {
+          close(fds[k].fd);
+          *owners[k] = -1;
+        }
+      }
+    }
+
+    // 已回收且输出都读完的任务整体输出
+    for (size_t k = 0; k < running.size();) {
+      ParallelJob &job = running[k];
+      if (!job.exited || job.out_fd != -1 || job.err_fd != -1) {
+        ++k;
+        continue;
+      }
+      int status = job.status;
+      write_all(STDOUT_FILENO, job.out);
+      write_all(STDERR_FILENO, job.err);
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        failed++;
+        std::cerr << "parallel: job " << job.index << " (" << job.input << ") ";
+        if (WIFSIGNALED(status)) {
+          std::cerr << "killed by signal " << WTERMSIG(status) << "\n";
+        } else {
+          std::cerr << "exited with status " << WEXITSTATUS(status) << "\n";
+        }
+      }
+      running.erase(running.begin() + k);
+    }
+  }
+  close(sig_fd);
+  sigprocmask(SIG_SETMASK, &old_mask, nullptr);
+
+  if (failed > 0) {
+    std::cerr << "parallel: " << failed << " of " << inputs.size() << " jobs failed\n";
+    return 1;
+  }
+  return 0;
 }
 
 // 经典的 cpp string split 实现
@@ -408,8 +1417,11 @@ std::vector<std::string> split(std::string s, const std::string &delimiter) {
   return res;
 }
 
-void sigint_handler(int sig) {
-  std::cout << "\n$ ";
-  // 命令没有输入完, ^C 会丢弃当前命令
-  std::cout.flush();
-}
\ No newline at end of file
+// 输入命令时终端处于 raw 模式，^C 由行编辑器处理并丢弃当前输入
+// 只有 Shell 进程内执行内建命令时才会收到 SIGINT，此时只换行，不再输出提示符
+void sigint_handler(int) {
+  // 信号处理函数中只能调用异步信号安全的函数
+  if (write(STDOUT_FILENO, "\n", 1) < 0) {
+    return;
+  }
+}